@@ -14,6 +14,14 @@
 //  pin 6 = (Header pin 22)
 //  pin 7 = (Header pin 7)  (Green)
 //
+//  Mode 4 (stream) reads timestamped frames from stdin, one per line:
+//
+//    <time ms> <mask>
+//
+//  where time is measured from the start of the stream and mask uses the
+//  same R/B/G bits as the command line. Point stdin at a FIFO to drive the
+//  LED from another program without relaunching blink for every change.
+//
 // Author       : Joshua Kiepert
 // Date         : 2013-03-08
 //============================================================================
@@ -27,6 +35,8 @@
 #include <signal.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
+#include <time.h>
 
 const int R_PIN = 0;
 const int B_PIN = 1;
@@ -38,10 +48,42 @@ const int G_MSK = 0x4;
 const int OFF = 1;
 const int ON = 0;
 
-static bool keepRunning = true;
+// Cleared by the signal handler and read by both threads
+static volatile sig_atomic_t keepRunning = true;
+
+// Streaming frames pass from the parser (main thread) to the output thread
+// through a single-producer/single-consumer ring. Neither side ever waits
+// on the other: a full ring drops the incoming frame.
+#define RING_SIZE 256
+#define LATE_US   1000
+
+struct frame {
+  uint64_t due;
+  uint8_t mask;
+};
+
+struct ring {
+  struct frame frames[RING_SIZE];
+  unsigned int head __attribute__((aligned(64)));   // written by consumer
+  unsigned int tail __attribute__((aligned(64)));   // written by producer
+};
+
+struct stream_stats {
+  unsigned long received;
+  unsigned long dropped;
+  unsigned long skipped;
+  unsigned long applied;
+  unsigned long late;
+  unsigned long bad;
+  uint64_t max_late;
+};
+
+static struct ring frameRing;
+static struct stream_stats streamStats;
+static bool streamEof = false;
 
 void intHandler(int dummy){
-  keepRunning = false;  
+  __atomic_store_n(&keepRunning, false, __ATOMIC_RELAXED);
 }
 
 bool timeout(int *countdown){
@@ -53,7 +95,7 @@ bool timeout(int *countdown){
   
   if(timed){
     if(*countdown == 0){
-      keepRunning = false;
+      __atomic_store_n(&keepRunning, false, __ATOMIC_RELAXED);
     }else{
       printf("\rTimeout in: %5d", *countdown);
       fflush(stdout);
@@ -61,7 +103,7 @@ bool timeout(int *countdown){
     }
   }
   
-  if(!keepRunning){
+  if(!__atomic_load_n(&keepRunning, __ATOMIC_RELAXED)){
     printf("\n");
     fflush(stdout);
     return true;
@@ -180,6 +222,151 @@ void led_blinker(int mask, int rate, int iterations){
   }
 }
 
+uint64_t now_us(void){
+  struct timespec ts;
+  
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+void sleep_until_us(uint64_t t){
+  struct timespec ts;
+  
+  ts.tv_sec = t / 1000000;
+  ts.tv_nsec = (t % 1000000) * 1000;
+  while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR && __atomic_load_n(&keepRunning, __ATOMIC_RELAXED));
+}
+
+bool ring_push(struct ring *r, struct frame f){
+  unsigned int tail = __atomic_load_n(&r->tail, __ATOMIC_RELAXED);
+  unsigned int head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+  
+  if(tail - head == RING_SIZE){
+    return false;
+  }
+  
+  r->frames[tail % RING_SIZE] = f;
+  __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+bool ring_peek(struct ring *r, struct frame *f){
+  unsigned int head = __atomic_load_n(&r->head, __ATOMIC_RELAXED);
+  unsigned int tail = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+  
+  if(head == tail){
+    return false;
+  }
+  
+  *f = r->frames[head % RING_SIZE];
+  return true;
+}
+
+void ring_pop(struct ring *r){
+  __atomic_store_n(&r->head, __atomic_load_n(&r->head, __ATOMIC_RELAXED) + 1, __ATOMIC_RELEASE);
+}
+
+// Timing-critical side of the stream. Sleeps until the next frame is due,
+// skips frames that a newer, already due frame has superseded, and applies
+// the rest.
+void *stream_output(void *arg){
+  struct stream_stats *st = &streamStats;
+  struct frame f, next;
+  uint64_t now, late;
+  
+  piHiPri(50);
+  
+  while(__atomic_load_n(&keepRunning, __ATOMIC_RELAXED)){
+    if(!ring_peek(&frameRing, &f)){
+      if(__atomic_load_n(&streamEof, __ATOMIC_ACQUIRE) && !ring_peek(&frameRing, &f)){
+        break;
+      }
+      usleep(500);
+      continue;
+    }
+    
+    now = now_us();
+    if(f.due > now){
+      // Wake at least every 10ms so SIGINT is noticed
+      sleep_until_us(f.due - now > 10000 ? now + 10000 : f.due);
+      continue;
+    }
+    
+    ring_pop(&frameRing);
+    
+    if(ring_peek(&frameRing, &next) && next.due <= now){
+      st->skipped++;
+      continue;
+    }
+    
+    led_set(f.mask);
+    st->applied++;
+    
+    late = now_us() - f.due;
+    if(late > LATE_US){
+      st->late++;
+    }
+    if(late > st->max_late){
+      st->max_late = late;
+    }
+  }
+  
+  return NULL;
+}
+
+// Parses frames from stdin and hands them to the output thread.
+void led_streamer(void){
+  struct stream_stats *st = &streamStats;
+  pthread_t outputThread;
+  char line[128];
+  struct frame f;
+  double ms;
+  int mask;
+  uint64_t start;
+  struct sigaction sa;
+  sigset_t sigint;
+  
+  // SIGINT must land on this thread, without SA_RESTART, so a blocked
+  // read of stdin returns and the stream shuts down.
+  memset(&sa, 0, sizeof(sa));
+  sa.sa_handler = intHandler;
+  sigaction(SIGINT, &sa, NULL);
+  sigemptyset(&sigint);
+  sigaddset(&sigint, SIGINT);
+  
+  start = now_us();
+  pthread_sigmask(SIG_BLOCK, &sigint, NULL);
+  pthread_create(&outputThread, NULL, stream_output, NULL);
+  pthread_sigmask(SIG_UNBLOCK, &sigint, NULL);
+  
+  while(__atomic_load_n(&keepRunning, __ATOMIC_RELAXED) && fgets(line, sizeof(line), stdin) != NULL){
+    if(line[0] == '#' || line[strspn(line, " \t\r\n")] == '\0'){
+      continue;
+    }
+    
+    if(sscanf(line, "%lf %i", &ms, &mask) != 2 || ms < 0){
+      st->bad++;
+      continue;
+    }
+    
+    f.due = start + (uint64_t)(ms * 1000);
+    f.mask = mask;
+    st->received++;
+    
+    if(!ring_push(&frameRing, f)){
+      st->dropped++;
+    }
+  }
+  
+  __atomic_store_n(&streamEof, true, __ATOMIC_RELEASE);
+  pthread_join(outputThread, NULL);
+  
+  printf("Frames: %lu received, %lu applied, %lu dropped (ring full), %lu skipped (superseded), %lu late (>%d us), %lu bad\n",
+         st->received, st->applied, st->dropped, st->skipped, st->late, LATE_US, st->bad);
+  printf("Max lateness: %llu us\n", (unsigned long long)st->max_late);
+  fflush(stdout);
+}
+
 void run(int mode, int mask, int rate, int iterations){
   
   switch(mode){
@@ -188,6 +375,11 @@ void run(int mode, int mask, int rate, int iterations){
       fflush(stdout); 
       led_setter(mask, iterations);
       break;
+    case 4:
+      printf("Mode: %d (stream), reading frames from stdin\n", mode);
+      fflush(stdout); 
+      led_streamer();
+      break;
     case 2:
       printf("Mode: %d (toggle), rate: %d, mask: %d, iterations: %d\n", mode, rate, mask, iterations);
       fflush(stdout); 
@@ -208,6 +400,7 @@ void run(int mode, int mask, int rate, int iterations){
 
 void usage(char *progname){
   fprintf(stdout, "Usage: %s [mode] [mask] [iterations] [blinkrate]\n" , progname);
+  fprintf(stdout, "       %s 4 < frames   (stream \"<time ms> <mask>\" lines)\n" , progname);
 }
 
 int main(int argc, char **argv)
@@ -0,0 +1,27 @@
+//============================================================================
+// Name         : wiringPi.h
+// Description  : Simulated wiringPi for building c/blink without GPIO
+//                hardware. See gpiosim.c.
+//
+// Date         : 2026-10-19
+//============================================================================
+
+#ifndef GPIOSIM_WIRINGPI_H
+#define GPIOSIM_WIRINGPI_H
+
+#define INPUT   0
+#define OUTPUT  1
+#define LOW     0
+#define HIGH    1
+
+int wiringPiSetup(void);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int piHiPri(int pri);
+
+// Waits advance the virtual clock instead of sleeping
+int gpiosim_usleep(unsigned int us);
+#define usleep(us) gpiosim_usleep(us)
+
+#endif
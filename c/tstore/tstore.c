@@ -0,0 +1,809 @@
+//============================================================================
+// Name         : tstore.c
+// Description  : Compact on-node time-series store for RPiCluster telemetry
+//
+// A store is a single preallocated, memory-mapped file:
+//
+//   block 0        file header (written once at creation)
+//   block 1..N     data blocks, used as a circular log
+//
+// Each 4 KiB data block starts with the absolute timestamp and channel
+// values of its first sample, followed by fixed-size records holding the
+// time delta (in units of the store resolution) and a 16-bit delta per
+// channel. A sample whose deltas do not fit starts a new block. Once all
+// blocks are used the oldest one is overwritten, so the file never grows.
+// Samples stamped before the newest one are dropped and counted per block;
+// query reports the count.
+//
+// The block being filled lives in RAM and is copied into the mapping and
+// msync'd only when it fills up or the flush interval expires. Every
+// write is therefore exactly one aligned 4 KiB page, and the flush
+// interval trades SD card write cycles against how much data a power cut
+// can lose. Readers only see flushed data.
+//
+// Usage:
+//   tstore create <file> [-d days] [-i interval s] [-r resolution ms] <channel>...
+//   tstore append <file> <value>...
+//   tstore record <file> [-d days] [-i interval s] [-f flush s]
+//   tstore query  <file> [-s start] [-e end] [-w bucket s]
+//   tstore bench  [-n samples] [-c channels]
+//
+// record samples the SoC temperature (m'C), CPU clock (MHz) and load
+// average (x100). query times are epoch seconds, or seconds before now
+// when negative.
+//
+// Date         : 2026-10-19
+//============================================================================
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define BLOCK_SIZE  4096
+#define MAX_CH      8
+#define NAME_LEN    16
+#define MAGIC       "RPITS01"
+
+// A value step or time gap too big for a record starts a new block before
+// the old one is full. Stores are sized for this many blocks per full
+// block's worth of samples so the requested retention survives that.
+const double BLOCK_HEADROOM = 1.25;
+
+struct ts_header {
+    char magic[8];
+    uint32_t block_size;
+    uint32_t nblocks;
+    uint32_t nchannels;
+    uint32_t resolution_ms;
+    char names[MAX_CH][NAME_LEN];
+};
+
+struct block_header {
+    uint32_t seq;       // 0 = never written
+    uint16_t count;     // samples in block, including the base sample
+    uint16_t dropped;   // samples refused for stamps before t_last
+    int64_t t_first;    // ms since the epoch
+    int64_t t_last;
+    int32_t base[MAX_CH];
+};
+
+struct tstore {
+    int fd;
+    uint8_t *map;
+    size_t map_size;
+    struct ts_header *hdr;
+    int recsize;
+    int capacity;
+    uint8_t block[BLOCK_SIZE] __attribute__((aligned(8)));
+    uint32_t cur;
+    uint32_t seq;
+    int32_t last[MAX_CH];
+    bool dirty;
+    unsigned long pages_written;
+    unsigned long dropped_backward;
+};
+
+struct bucket {
+    int64_t t;
+    int nchannels;
+    unsigned long count;
+    int32_t min[MAX_CH];
+    int32_t max[MAX_CH];
+    int64_t sum[MAX_CH];
+};
+
+typedef void (*bucket_fn)(const struct bucket *b, void *arg);
+
+// Cleared by the SIGINT/SIGTERM handler
+static volatile sig_atomic_t keepRunning = true;
+
+void intHandler(int dummy) {
+    keepRunning = false;
+}
+
+static int64_t now_ms(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (int64_t) ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static struct block_header *bh(struct tstore *ts) {
+    return (struct block_header*) ts->block;
+}
+
+static struct block_header *mapped_block(struct tstore *ts, uint32_t i) {
+    return (struct block_header*) (ts->map + (size_t) (i + 1) * BLOCK_SIZE);
+}
+
+// Record i (2..count) of a block; sample 1 is the base in the header.
+static int16_t *record_at(uint8_t *block, int recsize, int i) {
+    return (int16_t*) (block + sizeof(struct block_header) + (size_t) (i - 2) * recsize);
+}
+
+//----------------------------------------------------------------------------
+// Store file
+//----------------------------------------------------------------------------
+
+static int ts_map(struct tstore *ts, int flags) {
+    struct stat st;
+
+    if (fstat(ts->fd, &st) == -1 || st.st_size < BLOCK_SIZE) {
+        fprintf(stderr, "Not a tstore file\n");
+        return -1;
+    }
+
+    ts->map_size = st.st_size;
+    ts->map = mmap(NULL, ts->map_size, flags, MAP_SHARED, ts->fd, 0);
+    if (ts->map == MAP_FAILED) {
+        perror("mmap");
+        return -1;
+    }
+
+    ts->hdr = (struct ts_header*) ts->map;
+    if (memcmp(ts->hdr->magic, MAGIC, sizeof(MAGIC)) != 0 || ts->hdr->block_size != BLOCK_SIZE
+            || ts->hdr->nchannels < 1 || ts->hdr->nchannels > MAX_CH
+            || ts->map_size < (size_t) (ts->hdr->nblocks + 1) * BLOCK_SIZE) {
+        fprintf(stderr, "Not a tstore file\n");
+        munmap(ts->map, ts->map_size);
+        return -1;
+    }
+
+    ts->recsize = sizeof(uint16_t) + ts->hdr->nchannels * sizeof(int16_t);
+    ts->capacity = 1 + (BLOCK_SIZE - sizeof(struct block_header)) / ts->recsize;
+    return 0;
+}
+
+// Creates a store big enough for the given retention at the given sample
+// interval, as long as no more than 1 block in 5 is started early. The
+// whole file is allocated up front so appends never extend it.
+int ts_create(const char *path, double days, int interval_s, int resolution_ms, int nch, char **names) {
+    struct ts_header hdr;
+    int recsize = sizeof(uint16_t) + nch * sizeof(int16_t);
+    int capacity = 1 + (BLOCK_SIZE - sizeof(struct block_header)) / recsize;
+    double samples = days * 86400 / interval_s;
+    uint32_t nblocks = (uint32_t) (samples / capacity * BLOCK_HEADROOM) + 2;
+    int fd;
+
+    if (nch < 1 || nch > MAX_CH) {
+        fprintf(stderr, "Between 1 and %d channels are supported\n", MAX_CH);
+        return -1;
+    }
+
+    fd = open(path, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd == -1) {
+        fprintf(stderr, "Error creating %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    memset(&hdr, 0, sizeof(hdr));
+    memcpy(hdr.magic, MAGIC, sizeof(MAGIC));
+    hdr.block_size = BLOCK_SIZE;
+    hdr.nblocks = nblocks;
+    hdr.nchannels = nch;
+    hdr.resolution_ms = resolution_ms;
+    for (int i = 0; i < nch; i++) {
+        strncpy(hdr.names[i], names[i], NAME_LEN - 1);
+    }
+
+    if (ftruncate(fd, (off_t) (nblocks + 1) * BLOCK_SIZE) == -1
+            || pwrite(fd, &hdr, sizeof(hdr), 0) != sizeof(hdr)) {
+        fprintf(stderr, "Error writing %s: %s\n", path, strerror(errno));
+        close(fd);
+        unlink(path);
+        return -1;
+    }
+
+    fsync(fd);
+    close(fd);
+    return 0;
+}
+
+// Opens a store for appending. The newest block is reloaded into RAM so
+// appends continue where the last writer stopped.
+int ts_open(struct tstore *ts, const char *path) {
+    uint32_t newest = 0;
+
+    memset(ts, 0, sizeof(*ts));
+    ts->fd = open(path, O_RDWR);
+    if (ts->fd == -1) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    if (ts_map(ts, PROT_READ | PROT_WRITE) == -1) {
+        close(ts->fd);
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < ts->hdr->nblocks; i++) {
+        if (mapped_block(ts, i)->seq > ts->seq) {
+            ts->seq = mapped_block(ts, i)->seq;
+            newest = i;
+        }
+    }
+
+    ts->cur = newest;
+    if (ts->seq > 0) {
+        uint8_t *src = (uint8_t*) mapped_block(ts, newest);
+
+        memcpy(ts->block, src, BLOCK_SIZE);
+        memcpy(ts->last, bh(ts)->base, sizeof(ts->last));
+        for (int i = 2; i <= bh(ts)->count; i++) {
+            int16_t *rec = record_at(ts->block, ts->recsize, i);
+
+            for (uint32_t c = 0; c < ts->hdr->nchannels; c++) {
+                ts->last[c] += rec[1 + c];
+            }
+        }
+    }
+
+    return 0;
+}
+
+// Writes the RAM block over its slot in the file: one page, one msync.
+void ts_flush(struct tstore *ts) {
+    uint8_t *dst = (uint8_t*) mapped_block(ts, ts->cur);
+
+    if (!ts->dirty) {
+        return;
+    }
+
+    memcpy(dst, ts->block, BLOCK_SIZE);
+    msync(dst, BLOCK_SIZE, MS_SYNC);
+    ts->pages_written++;
+    ts->dirty = false;
+}
+
+static void ts_new_block(struct tstore *ts, int64_t t, const int32_t *v) {
+    ts_flush(ts);
+
+    if (ts->seq > 0) {
+        ts->cur = (ts->cur + 1) % ts->hdr->nblocks;
+    }
+
+    memset(ts->block, 0, BLOCK_SIZE);
+    bh(ts)->seq = ++ts->seq;
+    bh(ts)->count = 1;
+    bh(ts)->t_first = t;
+    bh(ts)->t_last = t;
+    memcpy(bh(ts)->base, v, ts->hdr->nchannels * sizeof(int32_t));
+    memcpy(ts->last, v, ts->hdr->nchannels * sizeof(int32_t));
+    ts->dirty = true;
+}
+
+// Appends one sample. The first sample of a block keeps its exact time;
+// later ones store the time since the previous sample truncated to the
+// store resolution. Queries rely on time never going backwards across the
+// log, so a sample stamped before the newest one (NTP stepping the clock
+// back on a Pi without an RTC) is dropped and counted in the block header
+// rather than stored at a made-up time.
+void ts_append(struct tstore *ts, int64_t t, const int32_t *v) {
+    struct block_header *b = bh(ts);
+    int64_t dt;
+    int16_t *rec;
+    bool fits;
+
+    if (ts->seq > 0 && t < b->t_last) {
+        ts->dropped_backward++;
+        if (b->dropped < UINT16_MAX) {
+            b->dropped++;
+        }
+        ts->dirty = true;
+        return;
+    }
+
+    dt = (t - b->t_last) / ts->hdr->resolution_ms;
+    fits = ts->seq > 0 && b->count < ts->capacity && dt <= UINT16_MAX;
+
+    for (uint32_t c = 0; fits && c < ts->hdr->nchannels; c++) {
+        int64_t dv = (int64_t) v[c] - ts->last[c];
+
+        fits = dv >= INT16_MIN && dv <= INT16_MAX;
+    }
+
+    if (!fits) {
+        ts_new_block(ts, t, v);
+        return;
+    }
+
+    rec = record_at(ts->block, ts->recsize, ++b->count);
+    rec[0] = (uint16_t) dt;
+    for (uint32_t c = 0; c < ts->hdr->nchannels; c++) {
+        rec[1 + c] = (int16_t) (v[c] - ts->last[c]);
+        ts->last[c] = v[c];
+    }
+
+    b->t_last += dt * ts->hdr->resolution_ms;
+    ts->dirty = true;
+}
+
+// Samples dropped for going back in time, over the blocks still in the log
+unsigned long ts_dropped(struct tstore *ts) {
+    unsigned long dropped = 0;
+
+    for (uint32_t i = 0; i < ts->hdr->nblocks; i++) {
+        if (mapped_block(ts, i)->seq > 0) {
+            dropped += mapped_block(ts, i)->dropped;
+        }
+    }
+    return dropped;
+}
+
+void ts_close(struct tstore *ts) {
+    ts_flush(ts);
+    munmap(ts->map, ts->map_size);
+    close(ts->fd);
+}
+
+//----------------------------------------------------------------------------
+// Query
+//----------------------------------------------------------------------------
+
+// Scans [start, end] in time order and reduces the samples to min/mean/max
+// per bucket. Blocks are kept in seq order, so the first block of interest
+// is found by binary search and blocks past the end stop the scan.
+unsigned long ts_query(struct tstore *ts, int64_t start, int64_t end, int64_t width, bucket_fn emit, void *arg) {
+    uint32_t n = ts->hdr->nblocks;
+    uint32_t nch = ts->hdr->nchannels;
+    uint32_t oldest = 0, valid = 0;
+    uint32_t lo, hi;
+    unsigned long scanned = 0;
+    struct bucket b;
+
+    for (uint32_t i = 0; i < n; i++) {
+        uint32_t seq = mapped_block(ts, i)->seq;
+
+        if (seq > 0) {
+            if (valid == 0 || seq < mapped_block(ts, oldest)->seq) {
+                oldest = i;
+            }
+            valid++;
+        }
+    }
+
+    // First block (in seq order) whose last sample is not before start
+    lo = 0;
+    hi = valid;
+    while (lo < hi) {
+        uint32_t mid = lo + (hi - lo) / 2;
+
+        if (mapped_block(ts, (oldest + mid) % n)->t_last < start) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+
+    memset(&b, 0, sizeof(b));
+    b.nchannels = nch;
+
+    for (uint32_t k = lo; k < valid; k++) {
+        uint8_t *block = (uint8_t*) mapped_block(ts, (oldest + k) % n);
+        struct block_header *h = (struct block_header*) block;
+        int32_t v[MAX_CH];
+        int64_t t = h->t_first;
+
+        if (h->t_first > end) {
+            break;
+        }
+
+        memcpy(v, h->base, sizeof(v));
+
+        for (int i = 1; i <= h->count; i++) {
+            if (i > 1) {
+                int16_t *rec = record_at(block, ts->recsize, i);
+
+                t += (int64_t) (uint16_t) rec[0] * ts->hdr->resolution_ms;
+                for (uint32_t c = 0; c < nch; c++) {
+                    v[c] += rec[1 + c];
+                }
+            }
+
+            scanned++;
+            if (t < start || t > end) {
+                continue;
+            }
+
+            int64_t bt = start + (t - start) / width * width;
+
+            if (b.count > 0 && bt != b.t) {
+                emit(&b, arg);
+                b.count = 0;
+            }
+
+            if (b.count == 0) {
+                b.t = bt;
+                for (uint32_t c = 0; c < nch; c++) {
+                    b.min[c] = b.max[c] = v[c];
+                    b.sum[c] = 0;
+                }
+            }
+
+            for (uint32_t c = 0; c < nch; c++) {
+                if (v[c] < b.min[c]) b.min[c] = v[c];
+                if (v[c] > b.max[c]) b.max[c] = v[c];
+                b.sum[c] += v[c];
+            }
+            b.count++;
+        }
+    }
+
+    if (b.count > 0) {
+        emit(&b, arg);
+    }
+
+    return scanned;
+}
+
+static void print_bucket(const struct bucket *b, void *arg) {
+    struct ts_header *hdr = arg;
+    time_t secs = b->t / 1000;
+    char when[32];
+
+    strftime(when, sizeof(when), "%Y-%m-%d %H:%M:%S", localtime(&secs));
+    printf("%s %6lu", when, b->count);
+
+    for (int c = 0; c < b->nchannels; c++) {
+        printf("  %s %d/%.1f/%d", hdr->names[c], b->min[c], (double) b->sum[c] / b->count, b->max[c]);
+    }
+
+    printf("\n");
+}
+
+//----------------------------------------------------------------------------
+// Sensors
+//----------------------------------------------------------------------------
+
+static int32_t read_int(const char *path) {
+    FILE *fp = fopen(path, "r");
+    long v = 0;
+
+    if (fp != NULL) {
+        if (fscanf(fp, "%ld", &v) != 1) {
+            v = 0;
+        }
+        fclose(fp);
+    }
+
+    return v;
+}
+
+static void read_sensors(int32_t *v) {
+    FILE *fp = fopen("/proc/loadavg", "r");
+    double load = 0;
+
+    v[0] = read_int("/sys/class/thermal/thermal_zone0/temp");
+    v[1] = read_int("/sys/devices/system/cpu/cpu0/cpufreq/scaling_cur_freq") / 1000;
+
+    if (fp != NULL) {
+        if (fscanf(fp, "%lf", &load) != 1) {
+            load = 0;
+        }
+        fclose(fp);
+    }
+    v[2] = (int32_t) (load * 100);
+}
+
+//----------------------------------------------------------------------------
+// Benchmark
+//----------------------------------------------------------------------------
+
+static double seconds(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void count_bucket(const struct bucket *b, void *arg) {
+    (*(unsigned long*) arg)++;
+}
+
+// Synthetic telemetry: 10 s samples of slowly wandering values with the
+// occasional step large enough to force a new block.
+static void bench(long nsamples, int nch) {
+    const int interval_s = 10;
+    const int flushes[] = {0, 3600, 600, 60};
+    char path[] = "/tmp/tstore-bench-XXXXXX";
+    char *names[MAX_CH] = {"c0", "c1", "c2", "c3", "c4", "c5", "c6", "c7"};
+    double days = (double) nsamples * interval_s / 86400;
+    double raw = (double) nsamples * (sizeof(int64_t) + nch * sizeof(int32_t));
+    int64_t t0 = 1000000000000LL;
+    struct tstore ts;
+    int fd;
+
+    fd = mkstemp(path);
+    if (fd == -1) {
+        perror("mkstemp");
+        exit(1);
+    }
+    close(fd);
+
+    printf("%ld samples x %d channels every %d s (%.1f days), raw %.0f KiB\n",
+            nsamples, nch, interval_s, days, raw / 1024);
+    printf("%-12s %10s %12s %10s %12s\n", "flush", "file KiB", "pages", "KiB/day", "write amp");
+
+    for (size_t f = 0; f < sizeof(flushes) / sizeof(flushes[0]); f++) {
+        unsigned int seed = 7;
+        int32_t v[MAX_CH] = {0};
+        int64_t last_flush = t0;
+        char label[16];
+        struct stat st;
+
+        unlink(path);
+        if (ts_create(path, days, interval_s, 1000, nch, names) == -1 || ts_open(&ts, path) == -1) {
+            exit(1);
+        }
+
+        for (long i = 0; i < nsamples; i++) {
+            int64_t t = t0 + (int64_t) i * interval_s * 1000;
+
+            for (int c = 0; c < nch; c++) {
+                v[c] += rand_r(&seed) % 21 - 10;
+                if (rand_r(&seed) % 5000 == 0) {
+                    v[c] += 100000;
+                }
+            }
+
+            ts_append(&ts, t, v);
+
+            if (flushes[f] > 0 && t - last_flush >= flushes[f] * 1000LL) {
+                ts_flush(&ts);
+                last_flush = t;
+            }
+        }
+
+        ts_close(&ts);
+        stat(path, &st);
+
+        if (flushes[f] == 0) {
+            snprintf(label, sizeof(label), "block full");
+        } else {
+            snprintf(label, sizeof(label), "%d s", flushes[f]);
+        }
+
+        printf("%-12s %10.0f %12lu %10.1f %12.3f\n", label, st.st_size / 1024.0, ts.pages_written,
+                ts.pages_written * (BLOCK_SIZE / 1024.0) / days, ts.pages_written * (double) BLOCK_SIZE / raw);
+    }
+
+    // Query speed on the last store
+    if (ts_open(&ts, path) == -1) {
+        exit(1);
+    }
+
+    int64_t t_end = t0 + (int64_t) nsamples * interval_s * 1000;
+    unsigned long buckets = 0, scanned;
+    unsigned int seed = 11;
+    int nqueries = 1000;
+    double start = seconds();
+
+    scanned = ts_query(&ts, t0, t_end, 3600 * 1000LL, count_bucket, &buckets);
+    double full = seconds() - start;
+
+    printf("full scan: %lu samples -> %lu hourly buckets in %.3f ms (%.1f M samples/s)\n",
+            scanned, buckets, full * 1e3, scanned / full / 1e6);
+    printf("retained: %lu of %ld samples (%.1f of %.1f days)\n",
+            scanned, nsamples, scanned * interval_s / 86400.0, days);
+
+    scanned = 0;
+    start = seconds();
+    for (int q = 0; q < nqueries; q++) {
+        int64_t from = t0 + (int64_t) (rand_r(&seed) % (nsamples * interval_s)) * 1000;
+
+        scanned += ts_query(&ts, from, from + 3600 * 1000LL, 60 * 1000LL, count_bucket, &buckets);
+    }
+    double window = (seconds() - start) / nqueries;
+
+    printf("1 h window: %.1f us per query, %lu samples decoded per query\n", window * 1e6, scanned / nqueries);
+
+    ts_close(&ts);
+    unlink(path);
+}
+
+//----------------------------------------------------------------------------
+// Commands
+//----------------------------------------------------------------------------
+
+void usage(char *progname) {
+    fprintf(stderr, "Usage: %s create <file> [-d days] [-i interval s] [-r resolution ms] <channel>...\n", progname);
+    fprintf(stderr, "       %s append <file> <value>...\n", progname);
+    fprintf(stderr, "       %s record <file> [-d days] [-i interval s] [-f flush s]\n", progname);
+    fprintf(stderr, "       %s query  <file> [-s start] [-e end] [-w bucket s]\n", progname);
+    fprintf(stderr, "       %s bench  [-n samples] [-c channels]\n", progname);
+}
+
+static int64_t parse_time(const char *s) {
+    long long v = atoll(s);
+
+    return v < 0 ? now_ms() + v * 1000 : v * 1000;
+}
+
+int main(int argc, char **argv) {
+    double days = 28;
+    int interval_s = 10;
+    int resolution_ms = 1000;
+    int flush_s = 600;
+    int64_t start = 0;
+    int64_t end = INT64_MAX;
+    int64_t width = 0;
+    long nsamples = 259200;
+    int nch = 3;
+    const char *cmd;
+    const char *path = NULL;
+    struct tstore ts;
+    int opt;
+
+    if (argc < 2) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    cmd = argv[1];
+    optind = 2;
+    if (strcmp(cmd, "bench") != 0) {
+        if (argc < 3) {
+            usage(argv[0]);
+            exit(1);
+        }
+        path = argv[2];
+        optind = 3;
+    }
+
+    // append takes only values, which may be negative: no options to parse
+    while (strcmp(cmd, "append") != 0 && (opt = getopt(argc, argv, "d:i:r:f:s:e:w:n:c:")) != -1) {
+        switch (opt) {
+            case 'd': days = atof(optarg); break;
+            case 'i': interval_s = atoi(optarg); break;
+            case 'r': resolution_ms = atoi(optarg); break;
+            case 'f': flush_s = atoi(optarg); break;
+            case 's': start = parse_time(optarg); break;
+            case 'e': end = parse_time(optarg); break;
+            case 'w': width = atoll(optarg) * 1000; break;
+            case 'n': nsamples = atol(optarg); break;
+            case 'c': nch = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    if (days <= 0 || interval_s < 1 || resolution_ms < 1 || nsamples < 1) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    if (strcmp(cmd, "create") == 0) {
+        if (ts_create(path, days, interval_s, resolution_ms, argc - optind, argv + optind) == -1
+                || ts_open(&ts, path) == -1) {
+            exit(1);
+        }
+
+        // Retention depends on the data: early block starts eat into it
+        printf("%s: %u blocks, %.1f days at %d s if every block fills, %.1f days requested\n", path,
+                ts.hdr->nblocks, (double) ts.hdr->nblocks * ts.capacity * interval_s / 86400, interval_s, days);
+        ts_close(&ts);
+
+    } else if (strcmp(cmd, "append") == 0) {
+        int32_t v[MAX_CH] = {0};
+
+        if (ts_open(&ts, path) == -1) {
+            exit(1);
+        }
+
+        if (argc - optind != (int) ts.hdr->nchannels) {
+            fprintf(stderr, "Expected %u values\n", ts.hdr->nchannels);
+            exit(1);
+        }
+
+        for (uint32_t c = 0; c < ts.hdr->nchannels; c++) {
+            char *end;
+            long value;
+
+            errno = 0;
+            value = strtol(argv[optind + c], &end, 10);
+            if (errno != 0 || end == argv[optind + c] || *end != '\0' || value < INT32_MIN || value > INT32_MAX) {
+                fprintf(stderr, "Invalid value: %s\n", argv[optind + c]);
+                exit(1);
+            }
+            v[c] = value;
+        }
+
+        ts_append(&ts, now_ms(), v);
+        if (ts.dropped_backward > 0) {
+            fprintf(stderr, "Sample dropped: stamped before the newest sample (clock stepped back)\n");
+        }
+        ts_close(&ts);
+
+    } else if (strcmp(cmd, "record") == 0) {
+        char *names[] = {"temp", "freq", "load"};
+        int nsensors = sizeof(names) / sizeof(names[0]);
+        int64_t last_flush = now_ms();
+        int32_t v[MAX_CH] = {0};
+
+        if (access(path, F_OK) != 0 && ts_create(path, days, interval_s, resolution_ms, nsensors, names) == -1) {
+            exit(1);
+        }
+
+        if (ts_open(&ts, path) == -1) {
+            exit(1);
+        }
+
+        // An existing store must have exactly the sensor channels
+        if (ts.hdr->nchannels != (uint32_t) nsensors) {
+            fprintf(stderr, "%s has %u channels, record needs %d (%s, %s, %s)\n", path, ts.hdr->nchannels,
+                    nsensors, names[0], names[1], names[2]);
+            ts_close(&ts);
+            exit(1);
+        }
+
+        signal(SIGINT, intHandler);
+        signal(SIGTERM, intHandler);
+
+        while (keepRunning) {
+            int64_t t = now_ms();
+
+            read_sensors(v);
+            ts_append(&ts, t, v);
+
+            if (t - last_flush >= flush_s * 1000LL) {
+                ts_flush(&ts);
+                last_flush = t;
+            }
+
+            sleep(interval_s);
+        }
+
+        if (ts.dropped_backward > 0) {
+            fprintf(stderr, "%lu samples dropped: stamped before an earlier sample (clock stepped back)\n",
+                    ts.dropped_backward);
+        }
+        ts_close(&ts);
+
+    } else if (strcmp(cmd, "query") == 0) {
+        memset(&ts, 0, sizeof(ts));
+        ts.fd = open(path, O_RDONLY);
+        if (ts.fd == -1) {
+            fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+            exit(1);
+        }
+
+        if (ts_map(&ts, PROT_READ) == -1) {
+            exit(1);
+        }
+
+        if (width <= 0) {
+            width = 1000;
+        }
+
+        ts_query(&ts, start, end, width, print_bucket, ts.hdr);
+        if (ts_dropped(&ts) > 0) {
+            fprintf(stderr, "%lu samples dropped: stamped before an earlier sample (clock stepped back)\n",
+                    ts_dropped(&ts));
+        }
+        munmap(ts.map, ts.map_size);
+        close(ts.fd);
+
+    } else if (strcmp(cmd, "bench") == 0) {
+        if (nch < 1 || nch > MAX_CH) {
+            usage(argv[0]);
+            exit(1);
+        }
+        bench(nsamples, nch);
+
+    } else {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    exit(0);
+}
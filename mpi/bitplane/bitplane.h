@@ -0,0 +1,89 @@
+//============================================================================
+// Name        : bitplane.h
+// Description : Bit-plane frame compositor for LED walls. A frame stores
+//               each color (and brightness) bit as a plane: one bit per
+//               node, 64 nodes to a word. Effects are whole-plane AND, OR,
+//               XOR and shift operations, so compositing a frame costs a
+//               few instructions per 64 nodes instead of a loop over every
+//               node, and frame_delta() lists only the nodes whose color
+//               changed, which are the only ones that need a message.
+//
+//               Node i of the wall is bit i % 64 of word i / 64. A node's
+//               value packs its planes the way pblink packs colors: plane
+//               p is bit p of the value, planes ordered red, green, blue
+//               with depth brightness bits each. With depth 1 a value is
+//               exactly a pblink MSK_R | MSK_G | MSK_B color mask.
+//
+// Date: 2026-10-19
+//============================================================================
+
+#ifndef BITPLANE_H
+#define BITPLANE_H
+
+#include <stdint.h>
+
+struct frame {
+    int nodes;
+    int depth;          // brightness bits per color
+    int planes;         // 3 * depth
+    int words;          // per plane, padded to the SIMD width
+    uint64_t *bits;     // plane p starts at bits + p * words
+};
+
+// The layers of pblink mode 18: a red wipe filling the wall column by
+// column, a blue row scanning down over it and a green checkerboard
+// toggled every fourth frame. Node (row, col) is bit row * row_step +
+// col * col_step, which covers row-major walls and the stack's ROW/COL
+// mask layouts.
+struct layers {
+    int nodes;          // rows * cols
+    int rows;
+    int cols;
+    int row_step;
+    int col_step;
+    uint64_t *first_col;
+    uint64_t *first_row;
+    uint64_t *checker;
+    uint64_t *wipe;
+    uint64_t *band;
+    uint64_t *tmp;
+};
+
+// Planes: masks over the wall, words long. Shift and range never write
+// bits past the last node, so planes compare equal word for word.
+const char *plane_simd(void);
+int plane_words(int nodes);
+uint64_t *plane_alloc(int words);
+void plane_and(uint64_t *dst, const uint64_t *a, const uint64_t *b, int words);
+void plane_or(uint64_t *dst, const uint64_t *a, const uint64_t *b, int words);
+void plane_xor(uint64_t *dst, const uint64_t *a, const uint64_t *b, int words);
+void plane_andnot(uint64_t *dst, const uint64_t *a, const uint64_t *b, int words);
+void plane_shift(uint64_t *dst, const uint64_t *src, int nodes, int k);
+void plane_range(uint64_t *dst, int nodes, int first, int count);
+int plane_count(const uint64_t *p, int words);
+
+static inline void plane_set(uint64_t *p, int node) {
+    p[node / 64] |= 1ULL << (node % 64);
+}
+
+static inline int plane_test(const uint64_t *p, int node) {
+    return (p[node / 64] >> (node % 64)) & 1;
+}
+
+// Frames. Every node of a new frame has value 0 (off).
+int frame_alloc(struct frame *f, int nodes, int depth);
+void frame_free(struct frame *f);
+void frame_copy(struct frame *dst, const struct frame *src);
+void frame_clear(struct frame *f);
+int frame_get(const struct frame *f, int node);
+void frame_paint(struct frame *f, const uint64_t *mask, int value);
+void frame_toggle(struct frame *f, const uint64_t *mask, int value);
+int frame_delta(const struct frame *prev, const struct frame *next, uint64_t *changed, int *nodes);
+
+// Layers. Frame t paints every layer at full brightness; one pass of the
+// pattern is (cols + 1) * rows frames.
+int layers_open(struct layers *l, int rows, int cols, int row_step, int col_step);
+void layers_close(struct layers *l);
+void layers_frame(struct layers *l, struct frame *f, long t);
+
+#endif
@@ -0,0 +1,246 @@
+//============================================================================
+// Name        : bpbench.c
+// Description : Microbenchmark for the bit-plane compositor. Composites
+//               the pblink mode 18 layers (red column wipe, blue row
+//               scan, green checkerboard toggled every fourth frame) with
+//               the same layers_frame() pblink calls, on walls of 32, 64, ... nodes and reports frames composited
+//               per second, delta encoding included, against the same
+//               pattern built one node at a time in an int array the way
+//               rank 0 walks its pattern arrays.
+//
+//               Walls are row-major on the squarest grid the node count
+//               allows (8x4 for 32). -d sets brightness bits per color:
+//               more planes per frame, same node count.
+//
+// Date: 2026-10-19
+//============================================================================
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include "bitplane.h"
+
+const int BATCH = 64;
+const int VERIFY_FRAMES = 64;
+
+struct wall {
+    int nodes;
+    int rows;
+    int cols;
+    int red;
+    int green;
+    int blue;
+    struct layers layers;
+    uint64_t *changed;
+    int *list;
+    struct frame frames[2];
+    int *colors[2];
+};
+
+struct result {
+    double fps;
+    double changed;     // nodes per frame that would get a message
+};
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void *alloc(size_t size) {
+    void *p = calloc(1, size);
+
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static uint64_t *alloc_plane(int words) {
+    uint64_t *p = plane_alloc(words);
+
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    return p;
+}
+
+static void wall_open(struct wall *w, int nodes, int depth) {
+    int words = plane_words(nodes);
+    int level = (1 << depth) - 1;
+
+    w->nodes = nodes;
+    w->cols = 1;
+    for (int i = 1; i * i <= nodes; i++) {
+        if (nodes % i == 0) {
+            w->cols = i;
+        }
+    }
+    w->rows = nodes / w->cols;
+    w->red = level;
+    w->green = level << depth;
+    w->blue = level << (2 * depth);
+
+    if (layers_open(&w->layers, w->rows, w->cols, w->cols, 1) == -1) {
+        fprintf(stderr, "Out of memory\n");
+        exit(1);
+    }
+    w->changed = alloc_plane(words);
+    w->list = alloc(nodes * sizeof(int));
+
+    for (int i = 0; i < 2; i++) {
+        if (frame_alloc(&w->frames[i], nodes, depth) == -1) {
+            fprintf(stderr, "Out of memory\n");
+            exit(1);
+        }
+        w->colors[i] = alloc(nodes * sizeof(int));
+    }
+}
+
+static void wall_close(struct wall *w) {
+    layers_close(&w->layers);
+    free(w->changed);
+    free(w->list);
+    for (int i = 0; i < 2; i++) {
+        frame_free(&w->frames[i]);
+        free(w->colors[i]);
+    }
+}
+
+// Frame t with the bit-plane compositor; returns the nodes that changed
+static int planes_frame(struct wall *w, long t) {
+    struct frame *prev = &w->frames[t % 2];
+    struct frame *next = &w->frames[(t + 1) % 2];
+
+    layers_frame(&w->layers, next, t);
+    return frame_delta(prev, next, w->changed, w->list);
+}
+
+// The same frame one node at a time
+static int array_frame(struct wall *w, long t) {
+    int *prev = w->colors[t % 2];
+    int *next = w->colors[(t + 1) % 2];
+    int k = t % (w->cols + 1);
+    int band = t % w->rows;
+    int toggle = (t / 4) % 2;
+    int n = 0;
+
+    for (int i = 0; i < w->nodes; i++) {
+        int row = i / w->cols;
+        int col = i % w->cols;
+        int c = col < k ? w->red : 0;
+
+        if (row == band) {
+            c = w->blue;
+        }
+        if (toggle && (row + col) % 2) {
+            c ^= w->green;
+        }
+
+        next[i] = c;
+        if (c != prev[i]) {
+            w->list[n++] = i;
+        }
+    }
+    return n;
+}
+
+// Both compositors must agree on every node of every frame of a wipe
+// cycle or two
+static int verify(struct wall *w) {
+    long frames = 2 * (w->cols + 1) > VERIFY_FRAMES ? 2 * (w->cols + 1) : VERIFY_FRAMES;
+
+    for (long t = 0; t < frames; t++) {
+        int n = planes_frame(w, t);
+
+        if (n != array_frame(w, t)) {
+            return -1;
+        }
+        for (int i = 0; i < w->nodes; i++) {
+            if (frame_get(&w->frames[(t + 1) % 2], i) != w->colors[(t + 1) % 2][i]) {
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
+static struct result run(struct wall *w, int (*frame)(struct wall*, long), double seconds) {
+    struct result r;
+    long changed = 0;
+    long t = 0;
+    double start = now();
+    double elapsed;
+
+    do {
+        for (int i = 0; i < BATCH; i++, t++) {
+            changed += frame(w, t);
+        }
+        elapsed = now() - start;
+    } while (elapsed < seconds);
+
+    r.fps = t / elapsed;
+    r.changed = (double) changed / t;
+    return r;
+}
+
+void usage(char *progname) {
+    fprintf(stderr, "Usage: %s [-N max nodes] [-d depth] [-t seconds]\n", progname);
+    fprintf(stderr, "  -N  largest wall, doubling from 32 (default 65536)\n");
+    fprintf(stderr, "  -d  brightness bits per color (default 1)\n");
+    fprintf(stderr, "  -t  seconds per compositor and wall size (default 0.5)\n");
+}
+
+int main(int argc, char **argv) {
+    int max_nodes = 65536;
+    int depth = 1;
+    double seconds = 0.5;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "N:d:t:")) != -1) {
+        switch (opt) {
+            case 'N': max_nodes = atoi(optarg); break;
+            case 'd': depth = atoi(optarg); break;
+            case 't': seconds = atof(optarg); break;
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    if (max_nodes < 32 || depth < 1 || depth > 8 || seconds <= 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    printf("%s planes, %d bit%s per color\n", plane_simd(), depth, depth > 1 ? "s" : "");
+    printf("%8s %8s %14s %14s %10s %14s\n", "nodes", "grid", "planes fps", "array fps", "speedup", "changed/frame");
+
+    for (int n = 32; n <= max_nodes; n *= 2) {
+        struct wall w;
+        struct result planes, array;
+        char grid[32];
+
+        wall_open(&w, n, depth);
+        if (verify(&w) == -1) {
+            fprintf(stderr, "bpbench: compositors disagree on a %d node wall\n", n);
+            exit(1);
+        }
+
+        planes = run(&w, planes_frame, seconds);
+        array = run(&w, array_frame, seconds);
+        snprintf(grid, sizeof(grid), "%dx%d", w.rows, w.cols);
+        printf("%8d %8s %14.0f %14.0f %9.1fx %14.1f\n", n, grid, planes.fps, array.fps, planes.fps / array.fps,
+                planes.changed);
+        fflush(stdout);
+        wall_close(&w);
+    }
+
+    exit(0);
+}
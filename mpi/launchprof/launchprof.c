@@ -0,0 +1,412 @@
+//============================================================================
+// Name        : launchprof.c
+// Description : Startup phase profiler for MPI programs (see launchprof.h).
+//
+//               Phases are timestamped on each rank's wall clock. Before
+//               gathering, rank 0 measures every rank's clock offset with a
+//               few ping-pongs, keeping the one with the shortest round
+//               trip, so phases from different Pis line up on one timeline.
+//
+//               Per rank the phases are:
+//                 launch   LAUNCHPROF_T0 -> process start (mpirun, ssh, orted)
+//                 exec     process start -> launchprof_start (loader, libs)
+//                 <mark>   previous mark -> launchprof_mark(<mark>)
+//
+// Date: 2026-10-19
+//============================================================================
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <time.h>
+#include <mpi.h>
+#include "launchprof.h"
+
+#define MAX_MARKS       16
+#define NAME_MAX_LEN    24
+#define HOST_MAX_LEN    32
+#define MAX_PHASES      (MAX_MARKS + 2)
+
+const int LAUNCHPROF_TAG = 0x4C50;
+const int SYNC_ROUNDS = 8;
+const int SLOWEST_SHOWN = 5;
+
+struct record {
+    char host[HOST_MAX_LEN];
+    int nmarks;
+    double exec;        // process start, 0 if unknown
+    double main;
+    double t[MAX_MARKS];
+    char name[MAX_MARKS][NAME_MAX_LEN];
+};
+
+// One rank's phases on rank 0's timeline, in seconds from the origin
+struct node {
+    int rank;
+    struct record rec;
+    double offset;      // add to the rank's clock to get rank 0's
+    double start[MAX_PHASES];
+    double dur[MAX_PHASES];     // -1 where the rank lacks the phase
+    double late;        // furthest behind the median start of any phase
+    int late_at;        // ...which phase that was
+    int blame;          // earlier phase furthest over its median
+};
+
+static struct record Prof;
+
+static double wall_time(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// Process start from /proc/self/stat (field 22, clock ticks since boot)
+static double process_start(void) {
+    char buf[1024];
+    unsigned long long ticks = 0;
+    struct timespec rt, bt;
+    char *p;
+    FILE *f = fopen("/proc/self/stat", "r");
+
+    if (!f) {
+        return 0;
+    }
+    p = fgets(buf, sizeof(buf), f);
+    fclose(f);
+
+    // The command name may contain spaces; fields resume after its ')'
+    if (!p || !(p = strrchr(buf, ')'))) {
+        return 0;
+    }
+    if (sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+            &ticks) != 1) {
+        return 0;
+    }
+
+    clock_gettime(CLOCK_REALTIME, &rt);
+    clock_gettime(CLOCK_BOOTTIME, &bt);
+    return (rt.tv_sec - bt.tv_sec) + (rt.tv_nsec - bt.tv_nsec) * 1e-9 + (double) ticks / sysconf(_SC_CLK_TCK);
+}
+
+void launchprof_start(void) {
+    Prof.main = wall_time();
+    Prof.exec = process_start();
+    gethostname(Prof.host, HOST_MAX_LEN);
+    Prof.host[HOST_MAX_LEN - 1] = '\0';
+}
+
+// Only the first mark of each name counts, so a phase that repeats (every
+// pattern opens with a barrier) records when it first completed
+void launchprof_mark(const char *phase) {
+    if (Prof.nmarks == MAX_MARKS) {
+        return;
+    }
+    for (int i = 0; i < Prof.nmarks; i++) {
+        if (strncmp(Prof.name[i], phase, NAME_MAX_LEN - 1) == 0) {
+            return;
+        }
+    }
+
+    Prof.t[Prof.nmarks] = wall_time();
+    strncpy(Prof.name[Prof.nmarks], phase, NAME_MAX_LEN - 1);
+    Prof.nmarks++;
+}
+
+// Rank 0 side of the offset estimate: the reply timestamp is assumed to
+// fall halfway through the round trip
+static double clock_offset(MPI_Comm comm, int rank) {
+    double best_rtt = 1e9;
+    double offset = 0;
+
+    for (int i = 0; i < SYNC_ROUNDS; i++) {
+        double t0 = wall_time();
+        double t1, remote;
+
+        MPI_Send(&t0, 1, MPI_DOUBLE, rank, LAUNCHPROF_TAG, comm);
+        MPI_Recv(&remote, 1, MPI_DOUBLE, rank, LAUNCHPROF_TAG, comm, MPI_STATUS_IGNORE);
+        t1 = wall_time();
+
+        if (t1 - t0 < best_rtt) {
+            best_rtt = t1 - t0;
+            offset = (t0 + t1) / 2 - remote;
+        }
+    }
+
+    return offset;
+}
+
+static void clock_reply(MPI_Comm comm) {
+    for (int i = 0; i < SYNC_ROUNDS; i++) {
+        double t;
+
+        MPI_Recv(&t, 1, MPI_DOUBLE, 0, LAUNCHPROF_TAG, comm, MPI_STATUS_IGNORE);
+        t = wall_time();
+        MPI_Send(&t, 1, MPI_DOUBLE, 0, LAUNCHPROF_TAG, comm);
+    }
+}
+
+static int phase_index(char names[][NAME_MAX_LEN], int *nphases, const char *name) {
+    for (int i = 0; i < *nphases; i++) {
+        if (strcmp(names[i], name) == 0) {
+            return i;
+        }
+    }
+    if (*nphases == MAX_PHASES) {
+        return -1;
+    }
+    strcpy(names[*nphases], name);
+    return (*nphases)++;
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+    return (x > y) - (x < y);
+}
+
+static int cmp_late(const void *a, const void *b) {
+    const struct node *x = *(struct node * const*) a;
+    const struct node *y = *(struct node * const*) b;
+    return (y->late > x->late) - (y->late < x->late);
+}
+
+// Median over the ranks that recorded phase p, of its duration (or of its
+// start, for starts)
+static double phase_median(struct node *nodes, int n, int p, bool starts, double *scratch) {
+    int k = 0;
+
+    for (int i = 0; i < n; i++) {
+        if (nodes[i].dur[p] >= 0) {
+            scratch[k++] = starts ? nodes[i].start[p] : nodes[i].dur[p];
+        }
+    }
+    if (k == 0) {
+        return 0;
+    }
+    qsort(scratch, k, sizeof(double), cmp_double);
+    return k % 2 ? scratch[k / 2] : (scratch[k / 2 - 1] + scratch[k / 2]) / 2;
+}
+
+// Index of the node with the longest (sign 1) or shortest (sign -1) phase p
+static int extreme(struct node *nodes, int n, int p, int sign) {
+    int best = -1;
+
+    for (int i = 0; i < n; i++) {
+        if (nodes[i].dur[p] >= 0 && (best < 0 || sign * (nodes[i].dur[p] - nodes[best].dur[p]) > 0)) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Writes s as a quoted JSON string. Host and phase names come from the
+// nodes and the program, so quotes, backslashes and control characters
+// are escaped.
+static void json_string(FILE *f, const char *s) {
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') {
+            fprintf(f, "\\%c", *s);
+        } else if ((unsigned char) *s < 0x20) {
+            fprintf(f, "\\u%04x", (unsigned char) *s);
+        } else {
+            fputc(*s, f);
+        }
+    }
+    fputc('"', f);
+}
+
+static void write_json(FILE *f, struct node *nodes, int n, char names[][NAME_MAX_LEN], int nphases,
+        double *median, double t0) {
+    fprintf(f, "{\n  \"ranks\": %d,\n  \"t0\": %.6f,\n  \"phases\": [\n", n, t0);
+    for (int p = 0; p < nphases; p++) {
+        int slowest = extreme(nodes, n, p, 1);
+
+        fprintf(f, "    {\"name\": ");
+        json_string(f, names[p]);
+        fprintf(f, ", \"median\": %.6f, \"max\": %.6f, \"slowest_rank\": %d, \"slowest_host\": ",
+                median[p], nodes[slowest].dur[p], nodes[slowest].rank);
+        json_string(f, nodes[slowest].rec.host);
+        fprintf(f, "}%s\n", p + 1 < nphases ? "," : "");
+    }
+
+    fprintf(f, "  ],\n  \"nodes\": [\n");
+    for (int i = 0; i < n; i++) {
+        fprintf(f, "    {\"rank\": %d, \"host\": ", nodes[i].rank);
+        json_string(f, nodes[i].rec.host);
+        fprintf(f, ", \"offset\": %.6f, \"late\": %.6f, \"late_at\": ", nodes[i].offset, nodes[i].late);
+        json_string(f, names[nodes[i].late_at]);
+        fprintf(f, ", \"phases\": {");
+        for (int p = 0, first = 1; p < nphases; p++) {
+            if (nodes[i].dur[p] >= 0) {
+                fprintf(f, "%s", first ? "" : ", ");
+                json_string(f, names[p]);
+                fprintf(f, ": %.6f", nodes[i].dur[p]);
+                first = 0;
+            }
+        }
+        fprintf(f, "}}%s\n", i + 1 < n ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+static void summarize(struct node *nodes, int n, double t0, const char *json_path) {
+    char names[MAX_PHASES][NAME_MAX_LEN];
+    double median[MAX_PHASES];
+    double median_start[MAX_PHASES];
+    double *scratch = malloc(n * sizeof(double));
+    struct node **order = malloc(n * sizeof(struct node*));
+    double origin = t0;
+    int nphases = 0;
+
+    // Without a launch timestamp the timeline starts at the earliest exec
+    if (origin <= 0) {
+        for (int i = 0; i < n; i++) {
+            double start = nodes[i].rec.exec > 0 ? nodes[i].rec.exec : nodes[i].rec.main;
+
+            if (origin <= 0 || start + nodes[i].offset < origin) {
+                origin = start + nodes[i].offset;
+            }
+        }
+    }
+
+    for (int i = 0; i < n; i++) {
+        struct node *nd = &nodes[i];
+        struct record *r = &nd->rec;
+        double prev = r->main;
+        int p;
+
+        for (p = 0; p < MAX_PHASES; p++) {
+            nd->dur[p] = -1;
+        }
+        // Process start has clock-tick resolution, so clamp at zero
+        if (t0 > 0 && r->exec > 0) {
+            double launch = r->exec + nd->offset - t0;
+
+            p = phase_index(names, &nphases, "launch");
+            nd->start[p] = 0;
+            nd->dur[p] = launch > 0 ? launch : 0;
+        }
+        if (r->exec > 0) {
+            p = phase_index(names, &nphases, "exec");
+            nd->start[p] = r->exec + nd->offset - origin;
+            nd->dur[p] = r->main - r->exec;
+        }
+        for (int k = 0; k < r->nmarks; k++) {
+            if ((p = phase_index(names, &nphases, r->name[k])) >= 0) {
+                nd->start[p] = prev + nd->offset - origin;
+                nd->dur[p] = r->t[k] - prev;
+            }
+            prev = r->t[k];
+        }
+        order[i] = nd;
+    }
+
+    for (int p = 0; p < nphases; p++) {
+        median[p] = phase_median(nodes, n, p, false, scratch);
+        median_start[p] = phase_median(nodes, n, p, true, scratch);
+    }
+
+    // MPI_Init and barriers make everyone wait for the last arrival, so a
+    // slow node shows up as starting some phase late rather than finishing
+    // late. Blame that on whichever earlier phase ran furthest over median.
+    for (int i = 0; i < n; i++) {
+        struct node *nd = &nodes[i];
+
+        nd->late = 0;
+        nd->late_at = 0;
+        nd->blame = -1;
+        for (int p = 0; p < nphases; p++) {
+            if (nd->dur[p] >= 0 && nd->start[p] - median_start[p] > nd->late) {
+                nd->late = nd->start[p] - median_start[p];
+                nd->late_at = p;
+            }
+        }
+        for (int p = 0; p < nd->late_at; p++) {
+            if (nd->dur[p] >= 0 && (nd->blame < 0 || nd->dur[p] - median[p] > nd->dur[nd->blame] - median[nd->blame])) {
+                nd->blame = p;
+            }
+        }
+    }
+
+    printf("Startup profile: %d ranks, times in ms from %s\n", n, t0 > 0 ? "launch" : "first process start");
+    printf("%-16s %10s %10s %10s  %s\n", "phase", "min", "median", "max", "slowest");
+    for (int p = 0; p < nphases; p++) {
+        int slowest = extreme(nodes, n, p, 1);
+        int fastest = extreme(nodes, n, p, -1);
+
+        printf("%-16s %10.1f %10.1f %10.1f  rank %d (%s)\n", names[p], nodes[fastest].dur[p] * 1e3, median[p] * 1e3,
+                nodes[slowest].dur[p] * 1e3, nodes[slowest].rank, nodes[slowest].rec.host);
+    }
+
+    qsort(order, n, sizeof(struct node*), cmp_late);
+    printf("Slowest nodes:\n");
+    for (int i = 0; i < n && i < SLOWEST_SHOWN && order[i]->late >= 1e-4; i++) {
+        struct node *nd = order[i];
+
+        printf("  rank %3d %-16s reached %s %.1f ms after median", nd->rank, nd->rec.host, names[nd->late_at],
+                nd->late * 1e3);
+        if (nd->blame >= 0) {
+            printf(" (%s %+.1f ms)", names[nd->blame], (nd->dur[nd->blame] - median[nd->blame]) * 1e3);
+        }
+        printf("\n");
+    }
+    fflush(stdout);
+
+    if (json_path) {
+        FILE *f = strcmp(json_path, "-") == 0 ? stdout : fopen(json_path, "w");
+
+        if (!f) {
+            perror(json_path);
+        } else {
+            write_json(f, nodes, n, names, nphases, median, t0);
+            if (f == stdout) {
+                fflush(f);
+            } else {
+                fclose(f);
+            }
+        }
+    }
+
+    free(order);
+    free(scratch);
+}
+
+void launchprof_report(MPI_Comm comm) {
+    int enabled = 0;
+    int me, nproc;
+
+    MPI_Comm_rank(comm, &me);
+    MPI_Comm_size(comm, &nproc);
+
+    // Only rank 0's environment counts: mpirun does not forward it to
+    // remote nodes, and every rank has to agree before any ping-pong
+    if (me == 0) {
+        enabled = getenv("LAUNCHPROF") != NULL;
+    }
+    MPI_Bcast(&enabled, 1, MPI_INT, 0, comm);
+    if (!enabled) {
+        return;
+    }
+
+    if (me == 0) {
+        struct node *nodes = calloc(nproc, sizeof(struct node));
+        const char *t0 = getenv("LAUNCHPROF_T0");
+
+        nodes[0].rec = Prof;
+        for (int r = 1; r < nproc; r++) {
+            nodes[r].rank = r;
+            nodes[r].offset = clock_offset(comm, r);
+            MPI_Recv(&nodes[r].rec, sizeof(struct record), MPI_BYTE, r, LAUNCHPROF_TAG, comm, MPI_STATUS_IGNORE);
+        }
+
+        summarize(nodes, nproc, t0 ? atof(t0) : 0, getenv("LAUNCHPROF_JSON"));
+        free(nodes);
+    } else {
+        clock_reply(comm);
+        MPI_Send(&Prof, sizeof(struct record), MPI_BYTE, 0, LAUNCHPROF_TAG, comm);
+    }
+}
@@ -0,0 +1,39 @@
+//============================================================================
+// Name        : launchprof.h
+// Description : Startup phase profiler shared by the MPI programs. Each rank
+//               timestamps its own startup phases; launchprof_report()
+//               aligns every rank to rank 0's clock, gathers the phases and
+//               names the slowest nodes and phases.
+//
+//               launchprof_start();            first thing in main()
+//               MPI_Init(&argc, &argv);
+//               launchprof_mark("MPI_Init");   end of each phase after that
+//               ...
+//               launchprof_report(MPI_COMM_WORLD);   collective, once
+//
+//               Reporting is off unless LAUNCHPROF is set in rank 0's
+//               environment. LAUNCHPROF_T0 (epoch seconds, set just before
+//               mpirun) adds the launch phase (ssh fan-out up to process
+//               start) and LAUNCHPROF_JSON=<file|-> also writes JSON.
+//               scripts/mpirun-launchprof sets all three. Building with
+//               -DLAUNCHPROF_OFF compiles the calls out.
+//
+// Date: 2026-10-19
+//============================================================================
+
+#ifndef LAUNCHPROF_H
+#define LAUNCHPROF_H
+
+#include <mpi.h>
+
+#ifdef LAUNCHPROF_OFF
+#define launchprof_start()
+#define launchprof_mark(phase)
+#define launchprof_report(comm)
+#else
+void launchprof_start(void);
+void launchprof_mark(const char *phase);
+void launchprof_report(MPI_Comm comm);
+#endif
+
+#endif
@@ -13,6 +13,23 @@
 //      pin 6 = (Header pin 22)
 //      pin 7 = (Header pin 7) (Green)
 //
+// Transport 1 runs the strobe, blink-all and row/column modes over a
+// one-sided frame board instead of sends and broadcasts: every rank
+// exposes a frame word and a stop word of RMA window memory, rank 0
+// MPI_Puts frames into the boards of the nodes a frame lights, and each
+// node checks its own board once per blink-rate tick. Chase modes need an
+// acknowledgement per step; asking for transport 1 with them or any other
+// mode without a frame board version falls back to transport 0 with a
+// warning.
+//
+// Modes 15-17 (wave, ripple, fire) have no master: the LED nodes form a
+// Cartesian grid from the ROW/COL layout and each one reacts only to its
+// neighbors through MPI_Neighbor_allgather. For these and the strobe modes
+// rank 0 also reports how many messages it and the busiest node sent.
+//
+// Mode 18 composites whole-wall layers with the bit-plane compositor in
+// ../bitplane and only sends to the nodes whose color changed.
+//
 // Author: Joshua Kiepert
 // Date: 2013-03-08
 // Modified: 2013-05-14
@@ -22,11 +39,15 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
+#include <string.h>
 #include <mpi.h>
 #include <wiringPi.h>
 #include <pthread.h>
 #include <signal.h>
 #include <stdbool.h>
+#include <time.h>
+#include "../launchprof/launchprof.h"
+#include "../bitplane/bitplane.h"
 
 const int R_PIN = 0;
 const int B_PIN = 1;
@@ -39,6 +60,9 @@ const int CHASE = 2;
 const int STROBE = 3;
 const int BLINK = 4;
 
+const int TWO_SIDED = 0;
+const int ONE_SIDED = 1;
+
 #define NETWORK_LAYOUT
 
 #ifdef NETWORK_LAYOUT
@@ -122,6 +146,19 @@ struct pstruct {
 };
 
 static bool Abort = false;
+static long Frames = 0;
+static long Sent = 0;        // by rank 0
+static long Busiest = 0;     // by the LED node that sent the most
+
+// One-sided frame board. A frame is a single aligned word, so it lands in
+// one piece: the put count in the high half, the blink rate in the low
+// half.
+struct board {
+    MPI_Win win;
+    int *word;      // [0] = seq << 16 | blinkrate, [1] = stop
+    int *out;       // last word put to each rank; origin buffers until flushed
+    int nproc;
+};
 
 void blink(int rate, int mask) {
     int us = 1000 * rate;
@@ -157,6 +194,13 @@ void intHandler(int dummy) {
     Abort = true;
 }
 
+// Every pattern opens with this barrier; the first one is the end of
+// startup for launchprof
+void pattern_barrier(void) {
+    MPI_Barrier(MPI_COMM_WORLD);
+    launchprof_mark("first barrier");
+}
+
 void blink_row_column(int me, int brate, int mask, int iterations) {
     int rows[] = {ROW0, ROW1, ROW2, ROW3, ROW4, ROW5, ROW6, ROW7};
     int rows_size = 8;
@@ -171,7 +215,7 @@ void blink_row_column(int me, int brate, int mask, int iterations) {
     int data[2];
     int delayms = 6;
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    pattern_barrier();
 
     if (me == 0) {
 
@@ -202,6 +246,7 @@ void blink_row_column(int me, int brate, int mask, int iterations) {
                     data[0] = blinkrate;
                     data[1] = rows[i];
                     MPI_Bcast(data, 2, MPI_INT, root, MPI_COMM_WORLD);
+                    Frames++;
 
                     if (blinkrate > 0)
                         usleep(1000 * blinkrate * delayms);
@@ -212,6 +257,7 @@ void blink_row_column(int me, int brate, int mask, int iterations) {
                     data[0] = blinkrate;
                     data[1] = rows[i];
                     MPI_Bcast(data, 2, MPI_INT, root, MPI_COMM_WORLD);
+                    Frames++;
 
                     if (blinkrate > 0)
                         usleep(1000 * blinkrate * delayms);
@@ -223,6 +269,7 @@ void blink_row_column(int me, int brate, int mask, int iterations) {
                     data[1] = columns[i];
 
                     MPI_Bcast(data, 2, MPI_INT, root, MPI_COMM_WORLD);
+                    Frames++;
 
                     if (blinkrate > 0)
                         usleep(1000 * blinkrate * delayms);
@@ -234,6 +281,7 @@ void blink_row_column(int me, int brate, int mask, int iterations) {
                     data[1] = columns[i];
 
                     MPI_Bcast(data, 2, MPI_INT, root, MPI_COMM_WORLD);
+                    Frames++;
 
                     if (blinkrate > 0)
                         usleep(1000 * blinkrate * delayms);
@@ -268,7 +316,7 @@ void blink_all(int me, int brate, int mask, int iterations) {
     bool keepRunning = true;
     int blinkrate = brate;
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    pattern_barrier();
 
     if (me == 0) {
 
@@ -296,8 +344,10 @@ void blink_all(int me, int brate, int mask, int iterations) {
 
             MPI_Bcast(&blinkrate, 1, MPI_INT, root, MPI_COMM_WORLD);
 
-            if (blinkrate > 0)
+            if (blinkrate > 0) {
+                Frames++;
                 usleep(1000 * blinkrate * 5);
+            }
         }
     } else {
         while (1) {
@@ -321,7 +371,7 @@ void chase(int me, int *pattern, int pattern_size, int brate, int mask, int iter
     MPI_Status status;
     int who;
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    pattern_barrier();
 
     if (me == 0) {
 
@@ -350,6 +400,9 @@ void chase(int me, int *pattern, int pattern_size, int brate, int mask, int iter
             for (int i = 0; i < pattern_size; i++) {
                 MPI_Send(&blinkrate, 1, MPI_INT, pattern[i], CHASE, MPI_COMM_WORLD);
                 MPI_Recv(&who, 1, MPI_INT, pattern[i], CHASE, MPI_COMM_WORLD, &status);
+                if (blinkrate > 0) {
+                    Frames++;
+                }
             }
         }
     } else {
@@ -374,7 +427,7 @@ void strobe(int me, int *pattern, int pattern_size, int brate, int mask, int ite
     int blinkrate = brate;
     MPI_Status status;
 
-    MPI_Barrier(MPI_COMM_WORLD);
+    pattern_barrier();
 
     if (me == 0) {
         if (iterations < 0) {
@@ -402,6 +455,8 @@ void strobe(int me, int *pattern, int pattern_size, int brate, int mask, int ite
             if (blinkrate > 0) {
                 for (int i = 0; i < pattern_size; i++) {
                     MPI_Send(&blinkrate, 1, MPI_INT, pattern[i], STROBE, MPI_COMM_WORLD);
+                    Frames++;
+                    Sent++;
 
                     if (blinkrate > 0) {
                         usleep(1000 * blinkrate);
@@ -412,6 +467,7 @@ void strobe(int me, int *pattern, int pattern_size, int brate, int mask, int ite
             } else {
                 for (int i = 0; i < stackwise_up_size; i++) {
                     MPI_Send(&blinkrate, 1, MPI_INT, stackwise_up[i], STROBE, MPI_COMM_WORLD);
+                    Sent++;
                 }
             }
         }
@@ -476,10 +532,561 @@ void multistrobe(int me, int *pattern1, int pattern1_size, int *pattern2, int pa
     }
 }
 
-void run(int me, int mode, int brate, int mask, int iterations) {
+//----------------------------------------------------------------------------
+// One-sided transport
+//----------------------------------------------------------------------------
+
+void board_open(struct board *b) {
+    MPI_Comm_size(MPI_COMM_WORLD, &b->nproc);
+    MPI_Win_allocate(2 * sizeof(int), sizeof(int), MPI_INFO_NULL, MPI_COMM_WORLD, &b->word, &b->win);
+    b->word[0] = 0;
+    b->word[1] = 0;
+    b->out = calloc(b->nproc, sizeof(int));
+
+    // Boards must be cleared before rank 0 can write to them
+    MPI_Barrier(MPI_COMM_WORLD);
+    MPI_Win_lock_all(0, b->win);
+}
+
+// Puts are only started here; board_flush completes all of a frame's puts
+// at once so their round trips overlap
+void board_put(struct board *b, int target, int blinkrate) {
+    int seq = ((b->out[target] >> 16) + 1) & 0x7FFF;
+
+    b->out[target] = (seq << 16) | (blinkrate & 0xFFFF);
+    MPI_Put(&b->out[target], 1, MPI_INT, target, 0, 1, MPI_INT, b->win);
+}
+
+void board_flush(struct board *b) {
+    MPI_Win_flush_all(b->win);
+}
+
+// The stop flag has its own word so it cannot overwrite a frame the
+// worker has not yet picked up
+void board_stop(struct board *b) {
+    static const int stop = 1;
+
+    for (int i = 1; i < b->nproc; i++) {
+        MPI_Put(&stop, 1, MPI_INT, i, 1, 1, MPI_INT, b->win);
+    }
+    board_flush(b);
+}
+
+// Collective. Returns the total number of frames workers never saw
+// because a newer frame overwrote them first (valid on rank 0).
+int board_close(struct board *b, int missed) {
+    int total = 0;
+
+    MPI_Win_unlock_all(b->win);
+    MPI_Reduce(&missed, &total, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+    MPI_Win_free(&b->win);
+    free(b->out);
+
+    return total;
+}
+
+// Worker side: check the local board at every frame deadline and blink
+// when a new frame has landed. Returns the number of frames missed.
+int board_worker(struct board *b, int brate, int mask) {
+    double tick = brate > 0 ? brate / 1000.0 : 0.001;
+    double next = MPI_Wtime();
+    int last = 0;
+    int missed = 0;
+
+    while (1) {
+        double now;
+        int word, seq, stop;
+
+        next += tick;
+        now = MPI_Wtime();
+        if (next > now) {
+            usleep((useconds_t) ((next - now) * 1e6));
+        } else {
+            next = now;
+        }
+
+        // Read stop before the frame: every frame was flushed before the
+        // stop flag, so a set flag means the last frame is visible too
+        MPI_Win_sync(b->win);
+        stop = ((volatile int*) b->word)[1];
+        word = ((volatile int*) b->word)[0];
+        seq = word >> 16;
+
+        if (seq != last) {
+            missed += ((seq - last) & 0x7FFF) - 1;
+            last = seq;
+            blink((short) (word & 0xFFFF), mask);
+        }
+
+        if (stop) {
+            return missed;
+        }
+    }
+}
+
+void rma_strobe(int me, int *pattern, int pattern_size, int brate, int mask, int iterations) {
+    struct board b;
+    int countdown = iterations;
+    int missed = 0;
+
+    board_open(&b);
+    pattern_barrier();
+
+    if (me == 0) {
+        while (!Abort && countdown != 0) {
+            if (countdown > 0) {
+                countdown--;
+            }
+
+            for (int i = 0; i < pattern_size; i++) {
+                board_put(&b, pattern[i], brate);
+                board_flush(&b);
+                Frames++;
+                usleep(1000 * brate);
+            }
+        }
+
+        board_stop(&b);
+    } else {
+        missed = board_worker(&b, brate, mask);
+    }
+
+    missed = board_close(&b, missed);
+    if (me == 0 && missed > 0) {
+        printf("Frames missed by workers: %d\n", missed);
+    }
+}
+
+void rma_blink_all(int me, int brate, int mask, int iterations) {
+    struct board b;
+    int countdown = iterations;
+    int missed = 0;
+
+    board_open(&b);
+    pattern_barrier();
+
+    if (me == 0) {
+        while (!Abort && countdown != 0) {
+            if (countdown > 0) {
+                countdown--;
+            }
+
+            for (int i = 1; i < b.nproc; i++) {
+                board_put(&b, i, brate);
+            }
+            board_flush(&b);
+            Frames++;
+            usleep(1000 * brate * 5);
+        }
+
+        board_stop(&b);
+    } else {
+        missed = board_worker(&b, brate, mask);
+    }
+
+    missed = board_close(&b, missed);
+    if (me == 0 && missed > 0) {
+        printf("Frames missed by workers: %d\n", missed);
+    }
+}
+
+void rma_blink_row_column(int me, int brate, int mask, int iterations) {
+    int frames[] = {ROW0, ROW1, ROW2, ROW3, ROW4, ROW5, ROW6, ROW7, ROW7, ROW6, ROW5, ROW4, ROW3, ROW2, ROW1, ROW0,
+                    COL0, COL1, COL2, COL3, COL3, COL2, COL1, COL0};
+    int frames_size = 24;
+    int delayms = 6;
+    struct board b;
+    int countdown = iterations;
+    int missed = 0;
+
+    board_open(&b);
+    pattern_barrier();
+
+    if (me == 0) {
+        while (!Abort && countdown != 0) {
+            if (countdown > 0) {
+                countdown--;
+            }
+
+            // Only the nodes a frame lights are written to
+            for (int f = 0; f < frames_size; f++) {
+                for (int i = 1; i < b.nproc && i <= 32; i++) {
+                    if (frames[f] & (1 << (i - 1))) {
+                        board_put(&b, i, brate);
+                    }
+                }
+                board_flush(&b);
+                Frames++;
+                usleep(1000 * brate * delayms);
+            }
+        }
+
+        board_stop(&b);
+    } else {
+        missed = board_worker(&b, brate, mask);
+    }
+
+    missed = board_close(&b, missed);
+    if (me == 0 && missed > 0) {
+        printf("Frames missed by workers: %d\n", missed);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Decentralized patterns
+//----------------------------------------------------------------------------
+
+// Each LED node is a cell on a Cartesian grid of the worker ranks and
+// only ever talks to its four grid neighbors: every step is one
+// MPI_Neighbor_allgather of the cell's state, after which each node
+// computes its next state from its neighbors alone. Rank 0 takes no part,
+// so the cost of a step does not grow with the wall.
+//
+// There is no master to say stop either. stop_at travels with the state
+// and every node keeps the smallest one it has seen; a node that wants to
+// stop (timed out or SIGINT) proposes a step far enough ahead that the
+// proposal reaches the whole grid first, so all nodes leave together.
+
+enum wave_kind {
+    WAVE, RIPPLE, FIRE
+};
+
+const int NORTH_NBR = 0;
+const int WEST_NBR = 2;
+const int RIPPLE_REFRACTORY = 3;
+const int FIRE_ASH_STEPS = 6;
+
+struct cell {
+    int state;
+    int stop_at;
+};
+
+struct wall {
+    MPI_Comm comm;
+    int dims[2];
+    int coords[2];
+    int neighbors;      // on the grid, out of 4
+};
+
+// Row/column of LED node n (1-based) in the ROW/COL masks
+static int mask_index(const int *masks, int count, int n) {
+    for (int i = 0; i < count; i++) {
+        if (((unsigned) masks[i] >> (n - 1)) & 1) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Collective over MPI_COMM_WORLD. The 32 node stack takes its shape and
+// positions from the ROW/COL masks; other walls use MPI_Dims_create in
+// rank order. Rank 0 gets MPI_COMM_NULL.
+void wall_open(int me, int nproc, struct wall *w) {
+    int rows[] = {ROW0, ROW1, ROW2, ROW3, ROW4, ROW5, ROW6, ROW7};
+    int columns[] = {COL0, COL1, COL2, COL3};
+    int periods[2] = {0, 0};
+    int key = me - 1;
+    int cart_rank;
+    MPI_Comm line;
+
+    w->dims[0] = w->dims[1] = 0;
+    if (nproc - 1 == 32) {
+        w->dims[0] = 8;
+        w->dims[1] = 4;
+        if (me > 0) {
+            key = mask_index(rows, 8, me) * 4 + mask_index(columns, 4, me);
+        }
+    } else {
+        MPI_Dims_create(nproc - 1 > 0 ? nproc - 1 : 1, 2, w->dims);
+    }
+
+    MPI_Comm_split(MPI_COMM_WORLD, me == 0 ? MPI_UNDEFINED : 0, key, &line);
+    w->comm = MPI_COMM_NULL;
+    if (line == MPI_COMM_NULL) {
+        return;
+    }
+
+    MPI_Cart_create(line, 2, w->dims, periods, 0, &w->comm);
+    MPI_Comm_free(&line);
+    MPI_Comm_rank(w->comm, &cart_rank);
+    MPI_Cart_coords(w->comm, cart_rank, 2, w->coords);
+
+    w->neighbors = (w->coords[0] > 0) + (w->coords[0] < w->dims[0] - 1) +
+                   (w->coords[1] > 0) + (w->coords[1] < w->dims[1] - 1);
+}
+
+// Deterministic per node, so a pattern replays identically
+static unsigned wave_random(unsigned *seed) {
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 17;
+    *seed ^= *seed << 5;
+    return *seed;
+}
+
+// nbr is north, south, west, east; -1 off the edge of the grid
+static int next_state(enum wave_kind kind, struct wall *w, int state, const struct cell *nbr, int step,
+        int period, unsigned *seed) {
+    bool excited = false;
+
+    switch (kind) {
+        case WAVE:
+            // A diagonal front from the top left corner
+            if (w->coords[0] == 0 && w->coords[1] == 0) {
+                return step % period == 0;
+            }
+            return nbr[NORTH_NBR].state == 1 || nbr[WEST_NBR].state == 1;
+
+        case RIPPLE:
+            // Excitable medium: rest (0), excited (1), then refractory so
+            // rings only travel outwards. The centre node pulses.
+            if (state > 0) {
+                return state < RIPPLE_REFRACTORY ? state + 1 : 0;
+            }
+            for (int i = 0; i < 4; i++) {
+                excited = excited || nbr[i].state == 1;
+            }
+            if (w->coords[0] == w->dims[0] / 2 && w->coords[1] == w->dims[1] / 2 && step % period == 0) {
+                excited = true;
+            }
+            return excited;
+
+        case FIRE:
+            // Forest fire: tree (0), burning (1), ash regrowing into a
+            // tree. Burning neighbors usually spread, lightning is rare.
+            if (state > 0) {
+                return state < FIRE_ASH_STEPS ? state + 1 : 0;
+            }
+            for (int i = 0; i < 4; i++) {
+                if (nbr[i].state == 1 && wave_random(seed) % 4 != 0) {
+                    excited = true;
+                }
+            }
+            return excited || wave_random(seed) % 512 == 0 || (step == 0 && w->coords[0] == w->dims[0] / 2 &&
+                    w->coords[1] == w->dims[1] / 2);
+    }
+
+    return 0;
+}
+
+static int wave_colors(enum wave_kind kind, int state) {
+    switch (kind) {
+        case WAVE: return state == 1 ? MSK_ALL : 0;
+        case RIPPLE: return state == 1 ? MSK_ALL : state == 2 ? MSK_B : 0;
+        case FIRE: return state == 1 ? MSK_R : state == 2 ? MSK_R | MSK_G : 0;
+    }
+    return 0;
+}
+
+static void show(int colors, int mask) {
+    digitalWrite(R_PIN, colors & mask & MSK_R ? ON : OFF);
+    digitalWrite(G_PIN, colors & mask & MSK_G ? ON : OFF);
+    digitalWrite(B_PIN, colors & mask & MSK_B ? ON : OFF);
+}
+
+// One iteration is long enough for a front to cross the grid
+void waves(int me, enum wave_kind kind, int brate, int mask, int iterations) {
+    struct wall w;
+    struct cell mine, nbr[4];
+    unsigned seed = 2463534242u + 97 * me;
+    int nproc, period, margin;
+    int state = 0;
+    long steps = 0;
+    long sent = 0;
+    long local[2], most[2] = {0, 0};
+
+    MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+    wall_open(me, nproc, &w);
+    pattern_barrier();
+
+    period = w.dims[0] + w.dims[1] - 1;
+    margin = w.dims[0] + w.dims[1];
+
+    if (w.comm != MPI_COMM_NULL) {
+        mine.stop_at = iterations < 0 ? -1 : iterations * period;
+
+        while (mine.stop_at < 0 || steps < mine.stop_at) {
+            if (Abort && (mine.stop_at < 0 || mine.stop_at > steps + margin)) {
+                mine.stop_at = steps + margin;
+            }
+
+            for (int i = 0; i < 4; i++) {
+                nbr[i].state = -1;
+                nbr[i].stop_at = -1;
+            }
+            mine.state = state;
+            MPI_Neighbor_allgather(&mine, 2, MPI_INT, nbr, 2, MPI_INT, w.comm);
+            sent += w.neighbors;
+
+            for (int i = 0; i < 4; i++) {
+                if (nbr[i].stop_at >= 0 && (mine.stop_at < 0 || nbr[i].stop_at < mine.stop_at)) {
+                    mine.stop_at = nbr[i].stop_at;
+                }
+            }
+
+            state = next_state(kind, &w, state, nbr, steps, period, &seed);
+            show(wave_colors(kind, state), mask);
+            usleep(1000 * brate);
+            steps++;
+        }
+
+        MPI_Comm_free(&w.comm);
+    }
+
+    // Rank 0 only learns how many frames the wall showed and what the
+    // busiest node sent
+    local[0] = steps;
+    local[1] = sent;
+    MPI_Reduce(local, most, 2, MPI_LONG, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (me == 0) {
+        Frames += most[0];
+        Busiest = most[1];
+        printf("Grid: %dx%d, %d hops corner to corner\n", w.dims[0], w.dims[1], w.dims[0] + w.dims[1] - 2);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Composited patterns
+//----------------------------------------------------------------------------
+
+// Rank 0 builds each frame from whole-wall layers instead of walking a
+// pattern array one node at a time: a red wipe filling the wall column
+// by column, a blue row scanning down over it and a green checkerboard
+// toggled every fourth frame (see struct layers in ../bitplane). Each
+// layer is a bit-plane over the LED nodes (node n is bit n - 1, as in the
+// ROW/COL masks), so a frame costs a handful of word operations however
+// large the wall is, and the delta against the last frame names the only
+// nodes that need a message.
+
+// The 32 node stack takes its layout from the ROW/COL masks; other walls
+// are row-major on an MPI_Dims_create grid, as in wall_open().
+static int layers_for_wall(int nodes, struct layers *l) {
+    int dims[2] = {0, 0};
+
+    if (nodes == 32) {
+        return layers_open(l, 8, 4, __builtin_ctz(ROW1) - __builtin_ctz(ROW0),
+                __builtin_ctz(COL1) - __builtin_ctz(COL0));
+    }
+
+    MPI_Dims_create(nodes, 2, dims);
+    return layers_open(l, dims[0], dims[1], dims[1], 1);
+}
+
+void composite(int me, int brate, int mask, int iterations) {
+    int color = -1;
+    int nproc;
+    MPI_Status status;
+
+    MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+    pattern_barrier();
+
+    if (me == 0) {
+        struct layers l = {0};
+        struct frame frames[2];
+        uint64_t *changed = plane_alloc(plane_words(nproc - 1));
+        int *nodes = malloc((nproc - 1) * sizeof(int));
+        long t;
+
+        if (layers_for_wall(nproc - 1, &l) == -1 || frame_alloc(&frames[0], nproc - 1, 1) == -1 ||
+                frame_alloc(&frames[1], nproc - 1, 1) == -1 || !changed || !nodes) {
+            fprintf(stderr, "Out of memory\n");
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+
+        for (t = 0; !Abort && (iterations < 0 || t < (long) iterations * (l.cols + 1) * l.rows); t++) {
+            struct frame *prev = &frames[t % 2];
+            struct frame *next = &frames[(t + 1) % 2];
+            int n;
+
+            layers_frame(&l, next, t);
+            n = frame_delta(prev, next, changed, nodes);
+            for (int i = 0; i < n; i++) {
+                color = frame_get(next, nodes[i]);
+                MPI_Send(&color, 1, MPI_INT, nodes[i] + 1, STROBE, MPI_COMM_WORLD);
+            }
+            Sent += n;
+            Frames++;
+            usleep(1000 * brate);
+        }
+
+        color = -1;
+        for (int i = 1; i < nproc; i++) {
+            MPI_Send(&color, 1, MPI_INT, i, STROBE, MPI_COMM_WORLD);
+        }
+        Sent += nproc - 1;
+
+        layers_close(&l);
+        frame_free(&frames[0]);
+        frame_free(&frames[1]);
+        free(changed);
+        free(nodes);
+    } else {
+        while (1) {
+            MPI_Recv(&color, 1, MPI_INT, 0, STROBE, MPI_COMM_WORLD, &status);
+
+            if (color < 0) {
+                return;
+            }
+
+            show(color, mask);
+        }
+    }
+}
+
+// Modes with a frame board implementation
+bool one_sided_mode(int mode) {
+    switch (mode) {
+        case 6: case 7: case 8: case 9: case 10: case 11: case 12: case 14:
+            return true;
+    }
+    return false;
+}
+
+// Runs a mode over the frame board; see one_sided_mode()
+void run_one_sided(int me, int mode, int brate, int mask, int iterations) {
+    switch (mode) {
+        case 6:
+            rma_strobe(me, stackwise_up, stackwise_up_size, brate, mask, iterations);
+            break;
+        case 7:
+            rma_strobe(me, stackwise_down, stackwise_down_size, brate, mask, iterations);
+            break;
+        case 8:
+            rma_strobe(me, horizontal_lr, horizontal_lr_size, brate, mask, iterations);
+            break;
+        case 9:
+            rma_strobe(me, horizontal_rl, horizontal_rl_size, brate, mask, iterations);
+            break;
+        case 10:
+            rma_strobe(me, spiral, spiral_size, brate, mask, iterations);
+            break;
+        case 11:
+            rma_strobe(me, zigzag, zigzag_size, brate, mask, iterations);
+            break;
+        case 12:
+            rma_blink_all(me, brate, mask, iterations);
+            break;
+        case 14:
+            rma_blink_row_column(me, brate, mask, iterations);
+            break;
+    }
+}
+
+static void leds_off(void) {
+    digitalWrite(R_PIN, OFF);
+    digitalWrite(G_PIN, OFF);
+    digitalWrite(B_PIN, OFF);
+}
+
+void run(int me, int mode, int brate, int mask, int iterations, int transport) {
     int msk = mask;
     int i = 0;
 
+    if (transport == ONE_SIDED) {
+        run_one_sided(me, mode, brate, mask, iterations);
+        leds_off();
+        return;
+    }
+
     switch (mode) {
         case 0:
             chase(me, stackwise_up, stackwise_up_size, brate, mask, iterations);
@@ -526,6 +1133,18 @@ void run(int me, int mode, int brate, int mask, int iterations) {
         case 14:
             blink_row_column(me, brate, mask, iterations);
             break;
+        case 15:
+            waves(me, WAVE, brate, mask, iterations);
+            break;
+        case 16:
+            waves(me, RIPPLE, brate, mask, iterations);
+            break;
+        case 17:
+            waves(me, FIRE, brate, mask, iterations);
+            break;
+        case 18:
+            composite(me, brate, mask, iterations);
+            break;
         default:
 
             if (me == 0) {
@@ -565,10 +1184,7 @@ void run(int me, int mode, int brate, int mask, int iterations) {
             }
     }
 
-    digitalWrite(R_PIN, OFF);
-    digitalWrite(G_PIN, OFF);
-    digitalWrite(B_PIN, OFF);
-
+    leds_off();
     return;
 }
 
@@ -581,9 +1197,14 @@ int main(int argc, char **argv) {
     int me;
     int nproc;
     int mask = MSK_ALL;
+    int transport = TWO_SIDED;
+    struct timespec cpuStart, cpuEnd;
+
+    launchprof_start();
 
     if (argc < 2) {
-        fprintf(stderr, "Usage: sudo %s <blink rate (ms)> [mode] [iterations] [mask]\n", argv[0]);
+        fprintf(stderr, "Usage: sudo %s <blink rate (ms)> [mode] [iterations] [mask] [transport]\n", argv[0]);
+        fprintf(stderr, "       transport: 0 = send/broadcast (default), 1 = one-sided frame board\n");
         exit(1);
     }
 
@@ -597,19 +1218,32 @@ int main(int argc, char **argv) {
         sscanf(argv[3], "%d", &iterations);
     }
 
-    if (argc == 5) {
+    if (argc >= 5) {
         sscanf(argv[4], "%d", &mask);
     }
 
+    if (argc == 6) {
+        sscanf(argv[5], "%d", &transport);
+    }
+
     MPI_Init(&argc, &argv);
     MPI_Comm_size(MPI_COMM_WORLD, &nproc);
     MPI_Comm_rank(MPI_COMM_WORLD, &me);
+    launchprof_mark("MPI_Init");
+
+    if (transport == ONE_SIDED && !one_sided_mode(mode)) {
+        if (me == 0) {
+            fprintf(stderr, "Warning: mode %d has no one-sided transport, using two-sided\n", mode);
+        }
+        transport = TWO_SIDED;
+    }
 
     if (wiringPiSetup() == -1) {
         printf("Error opening GPIO!\n");
         fflush(stdout);
         exit(1);
     }
+    launchprof_mark("wiringPiSetup");
 
     pinMode(R_PIN, OUTPUT);
     digitalWrite(R_PIN, OFF);
@@ -629,17 +1263,29 @@ int main(int argc, char **argv) {
         printf("Blinking at %d ms on %d processors...\n", blinkrate, nproc);
         printf("Set mode: %d\n", mode);
         printf("Set iterations: %d\n", iterations);
+        printf("Set transport: %s\n", transport == ONE_SIDED ? "one-sided" : "two-sided");
         fflush(stdout);
     }
 
-    run(me, mode, blinkrate, mask, iterations);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuStart);
+    run(me, mode, blinkrate, mask, iterations, transport);
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuEnd);
 
     if (me == 0) {
         timeElapsed = MPI_Wtime() - timeStart;
         printf("Elapsed time:  %lf seconds\n", timeElapsed);
+        printf("Rank 0 CPU time:  %lf seconds\n", (cpuEnd.tv_sec - cpuStart.tv_sec) + (cpuEnd.tv_nsec - cpuStart.tv_nsec) * 1e-9);
+        printf("Frames:  %ld (%.1f frames/s)\n", Frames, Frames / timeElapsed);
+        fflush(stdout);
+    }
+
+    // Only the strobe and decentralized modes count their messages
+    if (me == 0 && (Sent > 0 || Busiest > 0)) {
+        printf("Messages sent:  rank 0 %ld, busiest node %ld\n", Sent, Busiest);
         fflush(stdout);
     }
 
+    launchprof_report(MPI_COMM_WORLD);
     MPI_Finalize();
     exit(0);
 }
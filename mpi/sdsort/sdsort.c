@@ -0,0 +1,690 @@
+//============================================================================
+// Name        : sdsort.c
+// Description : MPI out-of-core sample sort of 64-bit keys, sized for the
+//               RPiCluster's SD cards and 512 MB of RAM per node
+//
+// Every rank sorts its share of the keys in a fixed memory budget, however
+// much input its node holds:
+//
+//   sample     read evenly spaced keys from the local input; rank 0 sorts
+//              the samples and broadcasts nproc - 1 splitters
+//   exchange   in rounds: read one chunk of input sequentially, partition
+//              it by splitter, MPI_Alltoallv the partitions. Received keys
+//              collect in the run buffer, which is sorted and spilled to a
+//              run file whenever the next round would not fit.
+//   merge      k-way merge of the run files through a heap, streaming each
+//              run and the output in large sequential blocks
+//
+// Each collective in the exchange is preceded by a barrier timed as "wait",
+// so time spent waiting for a slower rank (one that is spilling, say) is
+// reported as imbalance and the exchange rate is the network's.
+//
+// Afterwards every rank's output is sorted and all of rank r's keys are
+// <= rank r + 1's. The merge checks the local order, rank 0 checks the
+// boundaries and that the key count and sum survived the exchange.
+//
+// Each rank works in <scratch dir>/rank<N>/ (input.dat, run<i>.dat,
+// sorted.dat), so several ranks can share one host for testing. Writes
+// are fsync'd and dropped from the page cache so the throughput reported
+// per phase is the card's, not RAM's.
+//
+// Date: 2026-10-19
+//============================================================================
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <mpi.h>
+
+#define PATH_LEN        256
+#define NAME_LEN        32
+
+enum phase {
+    GENERATE, SAMPLE, READ, PARTITION, WAIT, EXCHANGE, SORT, SPILL, MERGE, NPHASES
+};
+
+const char *PHASE_NAMES[NPHASES] = {
+    "generate", "sample", "read", "partition", "wait", "exchange", "sort", "spill", "merge"
+};
+
+const int SAMPLES = 256;            // per rank
+const size_t MIN_BLOCK_KEYS = 512;
+const double MIB = 1024.0 * 1024.0;
+
+// Per rank; bytes are read + written for I/O phases, sent to other ranks
+// for the exchange and keys processed for partition and sort
+struct phase_stats {
+    double secs[NPHASES];
+    double bytes[NPHASES];
+};
+
+// Gathered to rank 0 for the global checks
+struct check {
+    uint64_t count_in;
+    uint64_t count_out;
+    uint64_t sum_in;
+    uint64_t sum_out;
+    uint64_t first;
+    uint64_t last;
+    int sorted;
+    int runs;
+};
+
+struct run {
+    int fd;
+    uint64_t *buf;
+    size_t n;
+    size_t pos;
+};
+
+static struct phase_stats Stats;
+static size_t Chunk = 1 << 20;
+static char Dir[PATH_LEN - NAME_LEN];
+
+static void fail(const char *what, const char *path) {
+    fprintf(stderr, "sdsort: %s %s: %s\n", what, path, strerror(errno));
+    MPI_Abort(MPI_COMM_WORLD, 1);
+}
+
+static void *xmalloc(size_t size) {
+    void *p = malloc(size > 0 ? size : 1);
+
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    return p;
+}
+
+static void *xcalloc(size_t n, size_t size) {
+    void *p = calloc(n > 0 ? n : 1, size);
+
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    return p;
+}
+
+static void *xrealloc(void *old, size_t size) {
+    void *p = realloc(old, size > 0 ? size : 1);
+
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    return p;
+}
+
+static void file_path(char *out, const char *name) {
+    snprintf(out, PATH_LEN, "%s/%s", Dir, name);
+}
+
+// Reads up to len bytes in Chunk-sized requests; short only at EOF
+static size_t read_full(int fd, void *buf, size_t len, const char *path) {
+    size_t done = 0;
+
+    while (done < len) {
+        size_t want = len - done < Chunk ? len - done : Chunk;
+        ssize_t got = read(fd, (char*) buf + done, want);
+
+        if (got < 0) {
+            fail("read", path);
+        }
+        if (got == 0) {
+            break;
+        }
+        done += got;
+    }
+    return done;
+}
+
+static void write_full(int fd, const void *buf, size_t len, const char *path) {
+    size_t done = 0;
+
+    while (done < len) {
+        size_t want = len - done < Chunk ? len - done : Chunk;
+        ssize_t put = write(fd, (const char*) buf + done, want);
+
+        if (put < 0) {
+            fail("write", path);
+        }
+        done += put;
+    }
+}
+
+// Flush to the card and evict, so later reads hit the card too
+static void close_written(int fd, const char *path) {
+    if (fsync(fd) != 0) {
+        fail("fsync", path);
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+}
+
+static int cmp_key(const void *a, const void *b) {
+    uint64_t x = *(const uint64_t*) a;
+    uint64_t y = *(const uint64_t*) b;
+    return (x > y) - (x < y);
+}
+
+//----------------------------------------------------------------------------
+// Phases
+//----------------------------------------------------------------------------
+
+// xorshift64*, seeded per rank
+static void generate(int me, double mib) {
+    char path[PATH_LEN];
+    uint64_t *buf = xmalloc(Chunk);
+    size_t per = Chunk / sizeof(uint64_t);
+    uint64_t total = (uint64_t) (mib * MIB) / sizeof(uint64_t);
+    uint64_t state = 0x9E3779B97F4A7C15ULL * (me + 1);
+    double t = MPI_Wtime();
+    int fd;
+
+    file_path(path, "input.dat");
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+        fail("open", path);
+    }
+
+    for (uint64_t done = 0; done < total; ) {
+        size_t n = total - done < per ? total - done : per;
+
+        for (size_t i = 0; i < n; i++) {
+            state ^= state >> 12;
+            state ^= state << 25;
+            state ^= state >> 27;
+            buf[i] = state * 0x2545F4914F6CDD1DULL;
+        }
+        write_full(fd, buf, n * sizeof(uint64_t), path);
+        done += n;
+    }
+
+    close_written(fd, path);
+    free(buf);
+
+    Stats.secs[GENERATE] = MPI_Wtime() - t;
+    Stats.bytes[GENERATE] = total * sizeof(uint64_t);
+}
+
+// Returns nproc - 1 splitters: rank r receives keys in
+// [splitters[r - 1], splitters[r])
+static uint64_t *choose_splitters(int fd, uint64_t nkeys, int me, int nproc) {
+    uint64_t local[SAMPLES];
+    uint64_t *splitters = xcalloc(nproc, sizeof(uint64_t));
+    uint64_t *all = NULL;
+    int *counts = NULL;
+    int *displs = NULL;
+    int n = nkeys < (uint64_t) SAMPLES ? (int) nkeys : SAMPLES;
+    int total = 0;
+    double t = MPI_Wtime();
+
+    // Offsets increase, so the card sees a forward sweep of small reads
+    for (int i = 0; i < n; i++) {
+        if (pread(fd, &local[i], sizeof(uint64_t), (i * nkeys / n) * sizeof(uint64_t)) != sizeof(uint64_t)) {
+            fail("read", "input.dat");
+        }
+    }
+    Stats.bytes[SAMPLE] = n * sizeof(uint64_t);
+
+    if (me == 0) {
+        counts = xmalloc(nproc * sizeof(int));
+        displs = xmalloc(nproc * sizeof(int));
+    }
+    MPI_Gather(&n, 1, MPI_INT, counts, 1, MPI_INT, 0, MPI_COMM_WORLD);
+
+    if (me == 0) {
+        for (int r = 0; r < nproc; r++) {
+            displs[r] = total;
+            total += counts[r];
+        }
+        all = xmalloc(total * sizeof(uint64_t));
+    }
+    MPI_Gatherv(local, n, MPI_UINT64_T, all, counts, displs, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    if (me == 0) {
+        qsort(all, total, sizeof(uint64_t), cmp_key);
+        for (int r = 1; r < nproc; r++) {
+            splitters[r - 1] = total > 0 ? all[(uint64_t) r * total / nproc] : 0;
+        }
+        free(all);
+        free(counts);
+        free(displs);
+    }
+    MPI_Bcast(splitters, nproc - 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    Stats.secs[SAMPLE] = MPI_Wtime() - t;
+    return splitters;
+}
+
+static int destination(const uint64_t *splitters, int nproc, uint64_t key) {
+    int lo = 0, hi = nproc - 1;
+
+    // First splitter above key; the last rank takes everything else
+    while (lo < hi) {
+        int mid = (lo + hi) / 2;
+
+        if (key < splitters[mid]) {
+            hi = mid;
+        } else {
+            lo = mid + 1;
+        }
+    }
+    return lo;
+}
+
+static void spill(uint64_t *keys, size_t n, int index) {
+    char name[NAME_LEN], path[PATH_LEN];
+    double t = MPI_Wtime();
+    int fd;
+
+    qsort(keys, n, sizeof(uint64_t), cmp_key);
+    Stats.secs[SORT] += MPI_Wtime() - t;
+    Stats.bytes[SORT] += n * sizeof(uint64_t);
+
+    t = MPI_Wtime();
+    snprintf(name, sizeof(name), "run%d.dat", index);
+    file_path(path, name);
+    if ((fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+        fail("open", path);
+    }
+    write_full(fd, keys, n * sizeof(uint64_t), path);
+    close_written(fd, path);
+
+    Stats.secs[SPILL] += MPI_Wtime() - t;
+    Stats.bytes[SPILL] += n * sizeof(uint64_t);
+}
+
+// Lines the ranks up before a collective, so the collective's time is
+// transfer time only
+static void wait_all(void) {
+    double t = MPI_Wtime();
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    Stats.secs[WAIT] += MPI_Wtime() - t;
+}
+
+// Returns the number of runs spilled. Rounds continue until every rank is
+// out of input, since each Alltoallv needs all ranks.
+static int exchange(int fd, const uint64_t *splitters, int me, int nproc, size_t budget, struct check *chk) {
+    size_t round = budget / 8 / sizeof(uint64_t);
+    size_t run_cap = (budget - 2 * round * sizeof(uint64_t)) / sizeof(uint64_t);
+    uint64_t *in = xmalloc(round * sizeof(uint64_t));
+    uint64_t *out = xmalloc(round * sizeof(uint64_t));
+    uint64_t *run = xmalloc(run_cap * sizeof(uint64_t));
+    int *scounts = xcalloc(nproc, sizeof(int));
+    int *sdispls = xcalloc(nproc, sizeof(int));
+    int *rcounts = xcalloc(nproc, sizeof(int));
+    int *rdispls = xcalloc(nproc, sizeof(int));
+    int *fill = xcalloc(nproc, sizeof(int));
+    size_t run_n = 0;
+    int runs = 0;
+
+    while (1) {
+        double t = MPI_Wtime();
+        size_t n = read_full(fd, in, round * sizeof(uint64_t), "input.dat") / sizeof(uint64_t);
+        size_t incoming = 0;
+        int more = n > 0;
+
+        Stats.secs[READ] += MPI_Wtime() - t;
+        Stats.bytes[READ] += n * sizeof(uint64_t);
+
+        wait_all();
+        t = MPI_Wtime();
+        MPI_Allreduce(MPI_IN_PLACE, &more, 1, MPI_INT, MPI_MAX, MPI_COMM_WORLD);
+        Stats.secs[EXCHANGE] += MPI_Wtime() - t;
+        if (!more) {
+            break;
+        }
+
+        // Counting sort of the chunk by destination rank
+        t = MPI_Wtime();
+        memset(scounts, 0, nproc * sizeof(int));
+        for (size_t i = 0; i < n; i++) {
+            chk->sum_in += in[i];
+            scounts[destination(splitters, nproc, in[i])]++;
+        }
+        for (int r = 0, d = 0; r < nproc; r++) {
+            sdispls[r] = fill[r] = d;
+            d += scounts[r];
+        }
+        for (size_t i = 0; i < n; i++) {
+            out[fill[destination(splitters, nproc, in[i])]++] = in[i];
+        }
+        chk->count_in += n;
+        Stats.secs[PARTITION] += MPI_Wtime() - t;
+        Stats.bytes[PARTITION] += n * sizeof(uint64_t);
+
+        wait_all();
+        t = MPI_Wtime();
+        MPI_Alltoall(scounts, 1, MPI_INT, rcounts, 1, MPI_INT, MPI_COMM_WORLD);
+        for (int r = 0; r < nproc; r++) {
+            rdispls[r] = incoming;
+            incoming += rcounts[r];
+        }
+        Stats.secs[EXCHANGE] += MPI_Wtime() - t;
+
+        if (run_n + incoming > run_cap && run_n > 0) {
+            spill(run, run_n, runs++);
+            run_n = 0;
+        }
+
+        // Only badly skewed splitters get here; stay correct, not bounded
+        if (incoming > run_cap) {
+            fprintf(stderr, "sdsort: rank %d received %zu keys in one round, over its %zu key budget\n",
+                    me, incoming, run_cap);
+            run_cap = incoming;
+            run = xrealloc(run, run_cap * sizeof(uint64_t));
+        }
+
+        wait_all();
+        t = MPI_Wtime();
+        MPI_Alltoallv(out, scounts, sdispls, MPI_UINT64_T, run + run_n, rcounts, rdispls, MPI_UINT64_T,
+                MPI_COMM_WORLD);
+        Stats.secs[EXCHANGE] += MPI_Wtime() - t;
+        Stats.bytes[EXCHANGE] += (double) (n - scounts[me]) * sizeof(uint64_t);
+        run_n += incoming;
+    }
+
+    if (run_n > 0) {
+        spill(run, run_n, runs++);
+    }
+
+    free(in);
+    free(out);
+    free(run);
+    free(scounts);
+    free(sdispls);
+    free(rcounts);
+    free(rdispls);
+    free(fill);
+    return runs;
+}
+
+static bool run_refill(struct run *r, size_t cap) {
+    r->n = read_full(r->fd, r->buf, cap * sizeof(uint64_t), "run") / sizeof(uint64_t);
+    r->pos = 0;
+    Stats.bytes[MERGE] += r->n * sizeof(uint64_t);
+    return r->n > 0;
+}
+
+// Binary min-heap of run indices ordered by each run's current key
+static void sift_down(int *heap, int n, struct run *runs, int i) {
+    while (1) {
+        int l = 2 * i + 1, r = l + 1, m = i, tmp;
+
+        if (l < n && runs[heap[l]].buf[runs[heap[l]].pos] < runs[heap[m]].buf[runs[heap[m]].pos]) {
+            m = l;
+        }
+        if (r < n && runs[heap[r]].buf[runs[heap[r]].pos] < runs[heap[m]].buf[runs[heap[m]].pos]) {
+            m = r;
+        }
+        if (m == i) {
+            return;
+        }
+        tmp = heap[i];
+        heap[i] = heap[m];
+        heap[m] = tmp;
+        i = m;
+    }
+}
+
+static void merge(int nruns, size_t budget, bool keep, struct check *chk) {
+    char name[NAME_LEN], path[PATH_LEN], out_path[PATH_LEN];
+    struct run *runs = xcalloc(nruns, sizeof(struct run));
+    int *heap = xmalloc(nruns * sizeof(int));
+    size_t cap = Chunk / sizeof(uint64_t);
+    size_t out_n = 0;
+    uint64_t *out;
+    uint64_t prev = 0;
+    double t = MPI_Wtime();
+    int n = 0;
+    int fd;
+
+    // One block per run plus the output block must fit the budget, but
+    // blocks under 4 KiB would turn the merge into random I/O
+    if ((nruns + 1) * Chunk > budget) {
+        cap = budget / (nruns + 1) / sizeof(uint64_t);
+        if (cap < MIN_BLOCK_KEYS) {
+            cap = MIN_BLOCK_KEYS;
+        }
+    }
+    out = xmalloc(cap * sizeof(uint64_t));
+
+    file_path(out_path, "sorted.dat");
+    if ((fd = open(out_path, O_WRONLY | O_CREAT | O_TRUNC, 0644)) < 0) {
+        fail("open", out_path);
+    }
+
+    for (int i = 0; i < nruns; i++) {
+        snprintf(name, sizeof(name), "run%d.dat", i);
+        file_path(path, name);
+        if ((runs[i].fd = open(path, O_RDONLY)) < 0) {
+            fail("open", path);
+        }
+        posix_fadvise(runs[i].fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+        runs[i].buf = xmalloc(cap * sizeof(uint64_t));
+        if (run_refill(&runs[i], cap)) {
+            heap[n++] = i;
+        }
+    }
+    for (int i = n / 2 - 1; i >= 0; i--) {
+        sift_down(heap, n, runs, i);
+    }
+
+    chk->sorted = 1;
+    while (n > 0) {
+        struct run *r = &runs[heap[0]];
+        uint64_t key = r->buf[r->pos++];
+
+        if (chk->count_out == 0) {
+            chk->first = key;
+        } else if (key < prev) {
+            chk->sorted = 0;
+        }
+        prev = key;
+        chk->count_out++;
+        chk->sum_out += key;
+
+        out[out_n++] = key;
+        if (out_n == cap) {
+            write_full(fd, out, out_n * sizeof(uint64_t), out_path);
+            Stats.bytes[MERGE] += out_n * sizeof(uint64_t);
+            out_n = 0;
+        }
+
+        if (r->pos == r->n && !run_refill(r, cap)) {
+            heap[0] = heap[--n];
+        }
+        sift_down(heap, n, runs, 0);
+    }
+    chk->last = prev;
+
+    write_full(fd, out, out_n * sizeof(uint64_t), out_path);
+    Stats.bytes[MERGE] += out_n * sizeof(uint64_t);
+    close_written(fd, out_path);
+
+    for (int i = 0; i < nruns; i++) {
+        close(runs[i].fd);
+        free(runs[i].buf);
+        if (!keep) {
+            snprintf(name, sizeof(name), "run%d.dat", i);
+            file_path(path, name);
+            unlink(path);
+        }
+    }
+
+    free(runs);
+    free(heap);
+    free(out);
+    Stats.secs[MERGE] = MPI_Wtime() - t;
+}
+
+//----------------------------------------------------------------------------
+// Reporting
+//----------------------------------------------------------------------------
+
+static bool check_all(struct check *all, int nproc) {
+    uint64_t count_in = 0, count_out = 0, sum_in = 0, sum_out = 0;
+    uint64_t last = 0;
+    bool any = false;
+    bool ok = true;
+
+    for (int r = 0; r < nproc; r++) {
+        count_in += all[r].count_in;
+        count_out += all[r].count_out;
+        sum_in += all[r].sum_in;
+        sum_out += all[r].sum_out;
+        ok = ok && all[r].sorted;
+
+        if (all[r].count_out > 0) {
+            if (any && all[r].first < last) {
+                ok = false;
+            }
+            last = all[r].last;
+            any = true;
+        }
+    }
+
+    return ok && count_in == count_out && sum_in == sum_out;
+}
+
+static void report(struct phase_stats *max, struct phase_stats *sum, struct check *all, int nproc,
+        size_t budget, double wall) {
+    uint64_t keys = 0;
+    int min_runs = all[0].runs, max_runs = all[0].runs;
+
+    for (int r = 0; r < nproc; r++) {
+        keys += all[r].count_out;
+        if (all[r].runs < min_runs) {
+            min_runs = all[r].runs;
+        }
+        if (all[r].runs > max_runs) {
+            max_runs = all[r].runs;
+        }
+    }
+
+    printf("Sorted %llu keys (%.1f MiB) on %d processors, %zu MiB memory and %zu KiB blocks per rank\n",
+            (unsigned long long) keys, keys * sizeof(uint64_t) / MIB, nproc, budget >> 20, Chunk >> 10);
+    printf("%-10s %10s %10s %12s %12s\n", "phase", "time (s)", "MiB", "MiB/s", "MiB/s/node");
+    for (int p = 0; p < NPHASES; p++) {
+        double rate = max->secs[p] > 0 ? sum->bytes[p] / MIB / max->secs[p] : 0;
+
+        if (max->secs[p] == 0 && sum->bytes[p] == 0) {
+            continue;
+        }
+        if (sum->bytes[p] == 0) {
+            printf("%-10s %10.3f\n", PHASE_NAMES[p], max->secs[p]);
+            continue;
+        }
+        printf("%-10s %10.3f %10.1f %12.1f %12.2f\n", PHASE_NAMES[p], max->secs[p], sum->bytes[p] / MIB,
+                rate, rate / nproc);
+    }
+    printf("%-10s %10.3f\n", "total", wall);
+    printf("Runs per rank: %d..%d, result %s\n", min_runs, max_runs,
+            check_all(all, nproc) ? "sorted" : "NOT SORTED");
+    fflush(stdout);
+}
+
+void usage(char *progname) {
+    fprintf(stderr, "Usage: %s [-d scratch dir] [-g MiB] [-m MiB] [-c KiB] [-k]\n", progname);
+    fprintf(stderr, "  -d  scratch directory; rank N uses <dir>/rank<N> (default sdsort-scratch)\n");
+    fprintf(stderr, "  -g  generate this many MiB of random keys per rank first (default: use input.dat)\n");
+    fprintf(stderr, "  -m  memory budget per rank in MiB (default 64)\n");
+    fprintf(stderr, "  -c  I/O block size in KiB (default 1024)\n");
+    fprintf(stderr, "  -k  keep the run files\n");
+}
+
+int main(int argc, char **argv) {
+    const char *base = "sdsort-scratch";
+    double gen_mib = 0;
+    size_t budget = 64;
+    bool keep = false;
+    struct phase_stats max, sum;
+    struct check chk = {0};
+    struct check *all = NULL;
+    char path[PATH_LEN];
+    uint64_t *splitters;
+    struct stat st;
+    double wall, wall_max;
+    int me;
+    int nproc;
+    int opt;
+    int fd;
+
+    while ((opt = getopt(argc, argv, "d:g:m:c:k")) != -1) {
+        switch (opt) {
+            case 'd': base = optarg; break;
+            case 'g': gen_mib = atof(optarg); break;
+            case 'm': budget = atoi(optarg); break;
+            case 'c': Chunk = (size_t) atoi(optarg) << 10; break;
+            case 'k': keep = true; break;
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    if (budget < 1 || Chunk < 4096 || gen_mib < 0) {
+        usage(argv[0]);
+        exit(1);
+    }
+    budget <<= 20;
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+    MPI_Comm_rank(MPI_COMM_WORLD, &me);
+
+    snprintf(Dir, sizeof(Dir), "%s/rank%d", base, me);
+    if ((mkdir(base, 0755) != 0 && errno != EEXIST) || (mkdir(Dir, 0755) != 0 && errno != EEXIST)) {
+        fail("mkdir", Dir);
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    wall = MPI_Wtime();
+
+    if (gen_mib > 0) {
+        generate(me, gen_mib);
+    }
+
+    file_path(path, "input.dat");
+    if ((fd = open(path, O_RDONLY)) < 0 || fstat(fd, &st) != 0) {
+        fail("open", path);
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    splitters = choose_splitters(fd, st.st_size / sizeof(uint64_t), me, nproc);
+    chk.runs = exchange(fd, splitters, me, nproc, budget, &chk);
+    close(fd);
+    free(splitters);
+
+    merge(chk.runs, budget, keep, &chk);
+
+    wall = MPI_Wtime() - wall;
+    MPI_Reduce(&wall, &wall_max, 1, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(Stats.secs, max.secs, NPHASES, MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    MPI_Reduce(Stats.bytes, sum.bytes, NPHASES, MPI_DOUBLE, MPI_SUM, 0, MPI_COMM_WORLD);
+
+    if (me == 0) {
+        all = xmalloc(nproc * sizeof(struct check));
+    }
+    MPI_Gather(&chk, sizeof(struct check), MPI_BYTE, all, sizeof(struct check), MPI_BYTE, 0, MPI_COMM_WORLD);
+
+    if (me == 0) {
+        report(&max, &sum, all, nproc, budget, wall_max);
+        free(all);
+    }
+
+    MPI_Finalize();
+    exit(0);
+}
@@ -0,0 +1,849 @@
+//============================================================================
+// Name        : taskfarm.c
+// Description : MPI work-stealing task farm for running batches of
+//               independent jobs on a cluster of Raspberry Pis
+//
+// Rank 0 reads a task list (one shell command per line, blank lines and
+// lines starting with '#' are ignored) and deals the tasks out to every
+// rank, itself included, in batches. Each rank runs its tasks one at a
+// time with /bin/sh. When a rank runs dry it asks a randomly chosen rank
+// for work and is handed half of that rank's remaining queue, so no rank
+// sits idle while another still has a backlog.
+//
+// Exit codes and captured output are sent back to rank 0 as soon as each
+// task finishes and are printed there in completion order.
+//
+// Benchmark mode (-B) replaces the task list with synthetic tasks of
+// uneven length and runs them once with a static distribution and once
+// with work stealing, reporting throughput and tail completion times.
+//
+// Date: 2026-10-19
+//============================================================================
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <mpi.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "../launchprof/launchprof.h"
+
+const int TASKS = 1;
+const int STEAL = 2;
+const int RESULT = 3;
+const int DONE = 4;
+
+#define OUTPUT_MAX 4096
+
+struct task {
+    int id;
+    double length;  // synthetic run time (s), only used when cmd is NULL
+    char *cmd;
+};
+
+struct deque {
+    struct task *items;
+    int head;
+    int tail;
+    int cap;
+};
+
+struct job {
+    bool active;
+    struct task task;
+    pid_t pid;
+    int fd;
+    int status;
+    double start;
+    double deadline;
+    char out[OUTPUT_MAX];
+    int out_len;
+};
+
+struct result {
+    int id;
+    int rank;
+    int status;
+    double start;
+    double finish;
+};
+
+struct outbox {
+    MPI_Request *reqs;
+    char **bufs;
+    int n;
+    int cap;
+};
+
+struct farm_opts {
+    int batch;
+    bool steal;
+    bool quiet;
+    int poll_us;
+};
+
+struct farm_stats {
+    int ntasks;
+    int completed;
+    int failed;
+    int steals;
+    double makespan;
+    double *finish;
+    struct task *tasks;
+};
+
+static bool Abort = false;
+static MPI_Comm Farm;  // private to one farm() run so stray steal traffic cannot leak between runs
+
+void intHandler(int dummy) {
+    Abort = true;
+}
+
+static void *xmalloc(size_t size) {
+    void *p = malloc(size > 0 ? size : 1);
+
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    return p;
+}
+
+static void *xrealloc(void *old, size_t size) {
+    void *p = realloc(old, size > 0 ? size : 1);
+
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory\n");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    return p;
+}
+
+static char *xstrdup(const char *s) {
+    size_t len = strlen(s);
+
+    return memcpy(xmalloc(len + 1), s, len + 1);
+}
+
+//----------------------------------------------------------------------------
+// Task queue. The owner pops from the head, thieves take from the tail.
+//----------------------------------------------------------------------------
+
+static int dq_size(struct deque *dq) {
+    return dq->tail - dq->head;
+}
+
+static void dq_push(struct deque *dq, struct task t) {
+    if (dq->tail == dq->cap) {
+        if (dq->head > 0) {
+            memmove(dq->items, dq->items + dq->head, dq_size(dq) * sizeof(struct task));
+            dq->tail -= dq->head;
+            dq->head = 0;
+        } else {
+            dq->cap = dq->cap ? dq->cap * 2 : 16;
+            dq->items = xrealloc(dq->items, dq->cap * sizeof(struct task));
+        }
+    }
+
+    dq->items[dq->tail++] = t;
+}
+
+static struct task dq_pop(struct deque *dq) {
+    return dq->items[dq->head++];
+}
+
+static void dq_free(struct deque *dq) {
+    for (int i = dq->head; i < dq->tail; i++) {
+        free(dq->items[i].cmd);
+    }
+
+    free(dq->items);
+    memset(dq, 0, sizeof(*dq));
+}
+
+//----------------------------------------------------------------------------
+// Task (de)serialization: count, then {id, length, cmdlen, cmd} per task.
+// A cmdlen of -1 marks a synthetic task.
+//----------------------------------------------------------------------------
+
+static char *pack_tasks(struct task *tasks, int n, int *size) {
+    int bytes = sizeof(int);
+    char *buf, *p;
+
+    for (int i = 0; i < n; i++) {
+        bytes += 2 * sizeof(int) + sizeof(double);
+        if (tasks[i].cmd != NULL) {
+            bytes += strlen(tasks[i].cmd);
+        }
+    }
+
+    buf = p = xmalloc(bytes);
+    memcpy(p, &n, sizeof(int));
+    p += sizeof(int);
+
+    for (int i = 0; i < n; i++) {
+        int len = tasks[i].cmd ? (int) strlen(tasks[i].cmd) : -1;
+
+        memcpy(p, &tasks[i].id, sizeof(int));
+        p += sizeof(int);
+        memcpy(p, &tasks[i].length, sizeof(double));
+        p += sizeof(double);
+        memcpy(p, &len, sizeof(int));
+        p += sizeof(int);
+
+        if (len > 0) {
+            memcpy(p, tasks[i].cmd, len);
+            p += len;
+        }
+    }
+
+    *size = bytes;
+    return buf;
+}
+
+static int unpack_tasks(const char *buf, struct deque *dq) {
+    const char *p = buf;
+    int n;
+
+    memcpy(&n, p, sizeof(int));
+    p += sizeof(int);
+
+    for (int i = 0; i < n; i++) {
+        struct task t;
+        int len;
+
+        memcpy(&t.id, p, sizeof(int));
+        p += sizeof(int);
+        memcpy(&t.length, p, sizeof(double));
+        p += sizeof(double);
+        memcpy(&len, p, sizeof(int));
+        p += sizeof(int);
+
+        t.cmd = NULL;
+        if (len >= 0) {
+            t.cmd = xmalloc(len + 1);
+            memcpy(t.cmd, p, len);
+            t.cmd[len] = '\0';
+            p += len;
+        }
+
+        dq_push(dq, t);
+    }
+
+    return n;
+}
+
+//----------------------------------------------------------------------------
+// Nonblocking sends. Buffers are kept until the matching request completes.
+//----------------------------------------------------------------------------
+
+static void post_send(struct outbox *o, char *buf, int size, int dest, int tag) {
+    if (o->n == o->cap) {
+        o->cap = o->cap ? o->cap * 2 : 16;
+        o->reqs = xrealloc(o->reqs, o->cap * sizeof(MPI_Request));
+        o->bufs = xrealloc(o->bufs, o->cap * sizeof(char*));
+    }
+
+    MPI_Isend(buf, size, MPI_BYTE, dest, tag, Farm, &o->reqs[o->n]);
+    o->bufs[o->n++] = buf;
+}
+
+static void reap_sends(struct outbox *o) {
+    int j = 0;
+
+    for (int i = 0; i < o->n; i++) {
+        int flag;
+
+        MPI_Test(&o->reqs[i], &flag, MPI_STATUS_IGNORE);
+        if (flag) {
+            free(o->bufs[i]);
+        } else {
+            o->reqs[j] = o->reqs[i];
+            o->bufs[j] = o->bufs[i];
+            j++;
+        }
+    }
+
+    o->n = j;
+}
+
+static void drain_sends(struct outbox *o) {
+    MPI_Waitall(o->n, o->reqs, MPI_STATUSES_IGNORE);
+
+    for (int i = 0; i < o->n; i++) {
+        free(o->bufs[i]);
+    }
+
+    free(o->reqs);
+    free(o->bufs);
+    memset(o, 0, sizeof(*o));
+}
+
+//----------------------------------------------------------------------------
+// Running tasks. Shell commands are forked so the farm loop keeps serving
+// steal requests and results while they run.
+//----------------------------------------------------------------------------
+
+static void job_start(struct job *job, struct task t) {
+    int fds[2];
+
+    job->active = true;
+    job->task = t;
+    job->status = 0;
+    job->out_len = 0;
+    job->pid = -1;
+    job->fd = -1;
+    job->start = MPI_Wtime();
+    job->deadline = job->start + t.length;
+
+    if (t.cmd == NULL) {
+        return;
+    }
+
+    if (pipe(fds) == -1) {
+        job->status = 127;
+        return;
+    }
+
+    fflush(stdout);
+    job->pid = fork();
+
+    if (job->pid == 0) {
+        dup2(fds[1], STDOUT_FILENO);
+        dup2(fds[1], STDERR_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execl("/bin/sh", "sh", "-c", t.cmd, (char*) NULL);
+        _exit(127);
+    }
+
+    close(fds[1]);
+
+    if (job->pid < 0) {
+        close(fds[0]);
+        job->status = 127;
+        return;
+    }
+
+    job->fd = fds[0];
+    fcntl(job->fd, F_SETFL, fcntl(job->fd, F_GETFL) | O_NONBLOCK);
+}
+
+static void job_read(struct job *job) {
+    char scratch[512];
+    ssize_t n;
+
+    while (job->fd >= 0) {
+        if (job->out_len < OUTPUT_MAX) {
+            n = read(job->fd, job->out + job->out_len, OUTPUT_MAX - job->out_len);
+        } else {
+            n = read(job->fd, scratch, sizeof(scratch));
+        }
+
+        if (n > 0) {
+            if (job->out_len < OUTPUT_MAX) {
+                job->out_len += n;
+            }
+        } else if (n == 0) {
+            close(job->fd);
+            job->fd = -1;
+        } else {
+            break;
+        }
+    }
+}
+
+// Returns true once the job has finished and job->status is valid.
+static bool job_poll(struct job *job) {
+    int status;
+
+    if (job->task.cmd == NULL) {
+        return MPI_Wtime() >= job->deadline;
+    }
+
+    if (job->pid < 0) {
+        return true;
+    }
+
+    job_read(job);
+
+    if (waitpid(job->pid, &status, WNOHANG) != job->pid) {
+        return false;
+    }
+
+    job_read(job);
+    if (job->fd >= 0) {
+        close(job->fd);
+        job->fd = -1;
+    }
+
+    if (WIFEXITED(status)) {
+        job->status = WEXITSTATUS(status);
+    } else if (WIFSIGNALED(status)) {
+        job->status = 128 + WTERMSIG(status);
+    }
+
+    return true;
+}
+
+static void job_kill(struct job *job) {
+    if (job->active && job->pid > 0) {
+        kill(job->pid, SIGTERM);
+        waitpid(job->pid, NULL, 0);
+    }
+
+    if (job->fd >= 0) {
+        close(job->fd);
+        job->fd = -1;
+    }
+
+    job->active = false;
+}
+
+//----------------------------------------------------------------------------
+// Results (rank 0)
+//----------------------------------------------------------------------------
+
+static void record_result(struct farm_stats *stats, struct result *r, const char *out, int out_len, bool quiet) {
+    stats->completed++;
+    stats->finish[r->id] = r->finish;
+
+    if (r->status != 0) {
+        stats->failed++;
+    }
+
+    if (quiet) {
+        return;
+    }
+
+    printf("[%4d] rank %2d exit %3d %8.3fs  %s\n", r->id, r->rank, r->status,
+            r->finish - r->start, stats->tasks[r->id].cmd ? stats->tasks[r->id].cmd : "(synthetic)");
+
+    if (out_len > 0) {
+        fwrite(out, 1, out_len, stdout);
+        if (out[out_len - 1] != '\n') {
+            printf("\n");
+        }
+    }
+
+    fflush(stdout);
+}
+
+//----------------------------------------------------------------------------
+// Farm
+//----------------------------------------------------------------------------
+
+// Rank 0 deals batches of tasks round robin and scatters them to all ranks.
+static void distribute(int me, int nproc, struct task *tasks, int ntasks, int batch, struct deque *dq) {
+    int *sizes = NULL;
+    int *displs = NULL;
+    char *sendbuf = NULL;
+    char *recvbuf;
+    int size;
+
+    if (me == 0) {
+        struct deque *dealt = xmalloc(nproc * sizeof(struct deque));
+        int total = 0;
+
+        memset(dealt, 0, nproc * sizeof(struct deque));
+
+        sizes = xmalloc(nproc * sizeof(int));
+        displs = xmalloc(nproc * sizeof(int));
+
+        for (int i = 0; i < ntasks; i++) {
+            dq_push(&dealt[(i / batch) % nproc], tasks[i]);
+        }
+
+        char **packed = xmalloc(nproc * sizeof(char*));
+        for (int r = 0; r < nproc; r++) {
+            packed[r] = pack_tasks(dealt[r].items, dq_size(&dealt[r]), &sizes[r]);
+            displs[r] = total;
+            total += sizes[r];
+            free(dealt[r].items);
+        }
+
+        sendbuf = xmalloc(total);
+        for (int r = 0; r < nproc; r++) {
+            memcpy(sendbuf + displs[r], packed[r], sizes[r]);
+            free(packed[r]);
+        }
+
+        free(packed);
+        free(dealt);
+    }
+
+    MPI_Scatter(sizes, 1, MPI_INT, &size, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    recvbuf = xmalloc(size);
+    MPI_Scatterv(sendbuf, sizes, displs, MPI_BYTE, recvbuf, size, MPI_BYTE, 0, MPI_COMM_WORLD);
+    unpack_tasks(recvbuf, dq);
+
+    free(recvbuf);
+    free(sendbuf);
+    free(sizes);
+    free(displs);
+}
+
+static void farm(int me, int nproc, struct task *tasks, int ntasks, struct farm_opts *opts, struct farm_stats *stats) {
+    struct deque dq = {0};
+    struct outbox outbox = {0};
+    struct job job = {0};
+    unsigned int seed = 1 + me;
+    bool done = false;
+    bool stealing = false;
+    double next_steal = 0;
+    int backoff_us = opts->poll_us;
+    int steals = 0;
+    double t0;
+
+    MPI_Comm_dup(MPI_COMM_WORLD, &Farm);
+    distribute(me, nproc, tasks, ntasks, opts->batch, &dq);
+
+    if (me == 0) {
+        stats->ntasks = ntasks;
+        stats->completed = 0;
+        stats->failed = 0;
+        stats->tasks = tasks;
+        stats->finish = xmalloc(ntasks * sizeof(double));
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    t0 = MPI_Wtime();
+
+    while (!done && !Abort) {
+        bool progress = false;
+        MPI_Status status;
+        int flag;
+
+        // Service incoming messages
+        MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, Farm, &flag, &status);
+        while (flag) {
+            int size;
+            char *buf;
+
+            MPI_Get_count(&status, MPI_BYTE, &size);
+            buf = xmalloc(size);
+            MPI_Recv(buf, size, MPI_BYTE, status.MPI_SOURCE, status.MPI_TAG, Farm, MPI_STATUS_IGNORE);
+            progress = true;
+
+            if (status.MPI_TAG == STEAL) {
+                // Keep the head of the queue for ourselves unless we are busy
+                int give = job.active ? (dq_size(&dq) + 1) / 2 : dq_size(&dq) / 2;
+                char *reply;
+                int reply_size;
+
+                reply = pack_tasks(dq.items + dq.tail - give, give, &reply_size);
+                for (int i = dq.tail - give; i < dq.tail; i++) {
+                    free(dq.items[i].cmd);
+                }
+                dq.tail -= give;
+
+                post_send(&outbox, reply, reply_size, status.MPI_SOURCE, TASKS);
+            } else if (status.MPI_TAG == TASKS) {
+                stealing = false;
+
+                if (unpack_tasks(buf, &dq) > 0) {
+                    steals++;
+                    backoff_us = opts->poll_us;
+                } else {
+                    next_steal = MPI_Wtime() + backoff_us * 1e-6;
+                    if (backoff_us < 50000) {
+                        backoff_us *= 2;
+                    }
+                }
+            } else if (status.MPI_TAG == RESULT) {
+                struct result r;
+
+                memcpy(&r, buf, sizeof(r));
+                record_result(stats, &r, buf + sizeof(r), size - (int) sizeof(r), opts->quiet);
+            } else if (status.MPI_TAG == DONE) {
+                done = true;
+            }
+
+            free(buf);
+            MPI_Iprobe(MPI_ANY_SOURCE, MPI_ANY_TAG, Farm, &flag, &status);
+        }
+
+        // Finish and start tasks
+        if (job.active && job_poll(&job)) {
+            struct result r = {job.task.id, me, job.status, job.start - t0, MPI_Wtime() - t0};
+
+            if (me == 0) {
+                record_result(stats, &r, job.out, job.out_len, opts->quiet);
+            } else {
+                char *buf = xmalloc(sizeof(r) + job.out_len);
+
+                memcpy(buf, &r, sizeof(r));
+                memcpy(buf + sizeof(r), job.out, job.out_len);
+                post_send(&outbox, buf, sizeof(r) + job.out_len, 0, RESULT);
+            }
+
+            free(job.task.cmd);
+            job.active = false;
+            progress = true;
+        }
+
+        if (!job.active && dq_size(&dq) > 0) {
+            job_start(&job, dq_pop(&dq));
+            progress = true;
+        }
+
+        // Out of work: ask a random rank for some of theirs
+        if (!job.active && opts->steal && !stealing && nproc > 1 && MPI_Wtime() >= next_steal) {
+            int victim = rand_r(&seed) % (nproc - 1);
+
+            if (victim >= me) {
+                victim++;
+            }
+
+            post_send(&outbox, NULL, 0, victim, STEAL);
+            stealing = true;
+        }
+
+        if (me == 0 && stats->completed == ntasks) {
+            for (int r = 1; r < nproc; r++) {
+                post_send(&outbox, NULL, 0, r, DONE);
+            }
+            stats->makespan = MPI_Wtime() - t0;
+            done = true;
+        }
+
+        reap_sends(&outbox);
+
+        if (!progress) {
+            usleep(opts->poll_us);
+        }
+    }
+
+    if (Abort) {
+        job_kill(&job);
+        free(job.task.cmd);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+
+    drain_sends(&outbox);
+    dq_free(&dq);
+    MPI_Comm_free(&Farm);
+
+    MPI_Reduce(&steals, &stats->steals, 1, MPI_INT, MPI_SUM, 0, MPI_COMM_WORLD);
+}
+
+//----------------------------------------------------------------------------
+// Task sources
+//----------------------------------------------------------------------------
+
+static struct task *read_tasks(const char *path, int *ntasks) {
+    FILE *fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+    struct deque dq = {0};
+    char *line = NULL;
+    size_t cap = 0;
+    ssize_t len;
+
+    if (fp == NULL) {
+        fprintf(stderr, "Error opening task list %s: %s\n", path, strerror(errno));
+        *ntasks = -1;
+        return NULL;
+    }
+
+    while ((len = getline(&line, &cap, fp)) != -1) {
+        char *s = line;
+
+        while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r')) {
+            line[--len] = '\0';
+        }
+
+        while (*s == ' ' || *s == '\t') {
+            s++;
+        }
+
+        if (*s == '\0' || *s == '#') {
+            continue;
+        }
+
+        struct task t = {dq_size(&dq), 0, xstrdup(s)};
+        dq_push(&dq, t);
+    }
+
+    free(line);
+    if (fp != stdin) {
+        fclose(fp);
+    }
+
+    *ntasks = dq_size(&dq);
+    return dq.items;
+}
+
+// Uneven synthetic work: mostly short tasks with one in eight running 10x
+// longer, so a static deal leaves some ranks with far more work than others.
+static struct task *synthetic_tasks(int ntasks, double mean_ms) {
+    struct task *tasks = xmalloc(ntasks * sizeof(struct task));
+    unsigned int seed = 42;
+
+    for (int i = 0; i < ntasks; i++) {
+        double u = (double) rand_r(&seed) / RAND_MAX;
+
+        tasks[i].id = i;
+        tasks[i].cmd = NULL;
+        tasks[i].length = mean_ms * 1e-3 * (0.25 + u);
+        if (rand_r(&seed) % 8 == 0) {
+            tasks[i].length *= 10;
+        }
+    }
+
+    return tasks;
+}
+
+//----------------------------------------------------------------------------
+// Benchmark
+//----------------------------------------------------------------------------
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double*) a;
+    double y = *(const double*) b;
+
+    return (x > y) - (x < y);
+}
+
+static void bench(int me, int nproc, int ntasks, double mean_ms, struct farm_opts *opts) {
+    struct task *tasks = NULL;
+    struct farm_stats stats = {0};
+    double work = 0;
+
+    if (me == 0) {
+        tasks = synthetic_tasks(ntasks, mean_ms);
+        for (int i = 0; i < ntasks; i++) {
+            work += tasks[i].length;
+        }
+
+        printf("%d synthetic tasks, %.3f s total work, batch %d, %d ranks (ideal makespan %.3f s)\n",
+                ntasks, work, opts->batch, nproc, work / nproc);
+        printf("%-8s %10s %10s %10s %10s %10s %8s\n",
+                "policy", "makespan", "tasks/s", "p50 (s)", "p99 (s)", "last (s)", "steals");
+        fflush(stdout);
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        opts->steal = pass == 1;
+        farm(me, nproc, tasks, ntasks, opts, &stats);
+
+        if (me == 0) {
+            qsort(stats.finish, ntasks, sizeof(double), cmp_double);
+            printf("%-8s %10.3f %10.1f %10.3f %10.3f %10.3f %8d\n",
+                    opts->steal ? "steal" : "static",
+                    stats.makespan,
+                    ntasks / stats.makespan,
+                    stats.finish[ntasks / 2],
+                    stats.finish[(int) (0.99 * (ntasks - 1))],
+                    stats.finish[ntasks - 1],
+                    stats.steals);
+            fflush(stdout);
+            free(stats.finish);
+        }
+    }
+
+    free(tasks);
+}
+
+void usage(char *progname) {
+    fprintf(stderr, "Usage: %s [-b batch] [-n] [-q] <task list | ->\n", progname);
+    fprintf(stderr, "       %s -B ntasks [-m mean task ms] [-b batch]\n", progname);
+    fprintf(stderr, "  -b  tasks per batch when dealing out work (default 8)\n");
+    fprintf(stderr, "  -n  no work stealing, keep the initial static deal\n");
+    fprintf(stderr, "  -q  only print the summary\n");
+    fprintf(stderr, "  -B  benchmark static vs. work stealing with synthetic tasks\n");
+    fprintf(stderr, "  -m  mean synthetic task length in ms (default 20)\n");
+}
+
+int main(int argc, char **argv) {
+    struct farm_opts opts = {8, true, false, 500};
+    struct farm_stats stats = {0};
+    struct task *tasks = NULL;
+    int ntasks = 0;
+    int bench_tasks = 0;
+    double mean_ms = 20;
+    int me;
+    int nproc;
+    int opt;
+
+    launchprof_start();
+
+    while ((opt = getopt(argc, argv, "b:nqB:m:")) != -1) {
+        switch (opt) {
+            case 'b':
+                opts.batch = atoi(optarg);
+                break;
+            case 'n':
+                opts.steal = false;
+                break;
+            case 'q':
+                opts.quiet = true;
+                break;
+            case 'B':
+                bench_tasks = atoi(optarg);
+                break;
+            case 'm':
+                mean_ms = atof(optarg);
+                break;
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    if (opts.batch < 1 || (bench_tasks <= 0 && optind != argc - 1)) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    MPI_Init(&argc, &argv);
+    MPI_Comm_size(MPI_COMM_WORLD, &nproc);
+    MPI_Comm_rank(MPI_COMM_WORLD, &me);
+    launchprof_mark("MPI_Init");
+
+    signal(SIGINT, intHandler);
+
+    if (bench_tasks > 0) {
+        opts.quiet = true;
+        bench(me, nproc, bench_tasks, mean_ms, &opts);
+        launchprof_report(MPI_COMM_WORLD);
+        MPI_Finalize();
+        exit(0);
+    }
+
+    if (me == 0) {
+        tasks = read_tasks(argv[optind], &ntasks);
+        if (ntasks < 0) {
+            MPI_Abort(MPI_COMM_WORLD, 1);
+        }
+    }
+
+    MPI_Bcast(&ntasks, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    launchprof_mark("task list");
+
+    if (ntasks > 0) {
+        farm(me, nproc, tasks, ntasks, &opts, &stats);
+    }
+
+    if (me == 0) {
+        printf("%d tasks on %d processors, %d failed, %d steals, %.3f seconds\n",
+                ntasks, nproc, stats.failed, stats.steals, stats.makespan);
+        fflush(stdout);
+
+        for (int i = 0; i < ntasks; i++) {
+            free(tasks[i].cmd);
+        }
+        free(tasks);
+        free(stats.finish);
+    }
+
+    MPI_Bcast(&stats.failed, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    launchprof_report(MPI_COMM_WORLD);
+    MPI_Finalize();
+    exit(stats.failed > 0 ? 1 : 0);
+}
@@ -0,0 +1,90 @@
+//============================================================================
+// Name        : mpi.h
+// Description : Subset of MPI implemented by the vcluster runtime. Programs
+//               such as pblink.c compile against this header unchanged and
+//               run as virtual nodes inside a single process.
+//
+// Date: 2026-10-19
+//============================================================================
+
+#ifndef VCLUSTER_MPI_H
+#define VCLUSTER_MPI_H
+
+typedef int MPI_Comm;
+typedef int MPI_Datatype;
+typedef int MPI_Op;
+typedef int MPI_Info;
+typedef int MPI_Win;
+
+typedef struct {
+    int MPI_SOURCE;
+    int MPI_TAG;
+    int count;              // bytes received
+} MPI_Status;
+
+#define MPI_SUCCESS         0
+#define MPI_COMM_WORLD      0
+#define MPI_COMM_NULL       (-1)
+#define MPI_UNDEFINED       (-32766)
+#define MPI_BYTE            ((MPI_Datatype) 1)
+#define MPI_CHAR            ((MPI_Datatype) 2)
+#define MPI_INT             ((MPI_Datatype) 3)
+#define MPI_LONG            ((MPI_Datatype) 4)
+#define MPI_FLOAT           ((MPI_Datatype) 5)
+#define MPI_DOUBLE          ((MPI_Datatype) 6)
+#define MPI_SUM             ((MPI_Op) 1)
+#define MPI_MAX             ((MPI_Op) 2)
+#define MPI_MIN             ((MPI_Op) 3)
+#define MPI_INFO_NULL       ((MPI_Info) 0)
+#define MPI_ANY_SOURCE      (-1)
+#define MPI_ANY_TAG         (-1)
+#define MPI_STATUS_IGNORE   ((MPI_Status*) 0)
+
+int MPI_Init(int *argc, char ***argv);
+int MPI_Finalize(void);
+int MPI_Abort(MPI_Comm comm, int code);
+int MPI_Comm_size(MPI_Comm comm, int *size);
+int MPI_Comm_rank(MPI_Comm comm, int *rank);
+int MPI_Send(const void *buf, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm);
+int MPI_Recv(void *buf, int count, MPI_Datatype type, int source, int tag, MPI_Comm comm, MPI_Status *status);
+int MPI_Get_count(const MPI_Status *status, MPI_Datatype type, int *count);
+int MPI_Bcast(void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm);
+int MPI_Barrier(MPI_Comm comm);
+int MPI_Reduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op, int root, MPI_Comm comm);
+
+// Communicators split from MPI_COMM_WORLD and 2-d Cartesian grids on them.
+// The other collectives still span MPI_COMM_WORLD whatever comm is given.
+int MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm *newcomm);
+int MPI_Comm_free(MPI_Comm *comm);
+int MPI_Dims_create(int nnodes, int ndims, int *dims);
+int MPI_Cart_create(MPI_Comm comm, int ndims, const int *dims, const int *periods, int reorder, MPI_Comm *cart);
+int MPI_Cart_coords(MPI_Comm comm, int rank, int maxdims, int *coords);
+int MPI_Neighbor_allgather(const void *sendbuf, int scount, MPI_Datatype stype, void *recvbuf, int rcount,
+        MPI_Datatype rtype, MPI_Comm comm);
+
+// One-sided: windows live in the owning node's memory, puts complete
+// immediately, so the synchronization calls only order memory accesses.
+int MPI_Win_allocate(long size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr, MPI_Win *win);
+int MPI_Win_free(MPI_Win *win);
+int MPI_Win_lock_all(int assert, MPI_Win win);
+int MPI_Win_unlock_all(MPI_Win win);
+int MPI_Win_flush(int rank, MPI_Win win);
+int MPI_Win_flush_all(MPI_Win win);
+int MPI_Win_sync(MPI_Win win);
+int MPI_Put(const void *origin, int origin_count, MPI_Datatype origin_type, int target, long target_disp,
+        int target_count, MPI_Datatype target_type, MPI_Win win);
+double MPI_Wtime(void);
+
+// Blocking calls a virtual node makes must yield to the scheduler instead
+// of stalling a worker thread, and leaving main() must only end that node.
+void vc_usleep(unsigned int us);
+void vc_exit(int code) __attribute__((noreturn));
+int vc_printf(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+#ifndef VCLUSTER_RUNTIME
+#define usleep(us)      vc_usleep(us)
+#define exit(code)      vc_exit(code)
+#define printf(...)     vc_printf(__VA_ARGS__)
+#endif
+
+#endif
@@ -0,0 +1,1240 @@
+//============================================================================
+// Name        : vcluster.c
+// Description : Virtual cluster runtime. Hosts N logical MPI ranks as
+//               coroutines scheduled on a small pool of worker threads in
+//               one process, so pblink patterns and their 32-node
+//               assumptions can be exercised with hundreds of nodes and
+//               no Raspberry Pis.
+//
+// pblink.c is compiled unchanged against the mpi.h and wiringPi.h in this
+// directory. Each virtual node runs pblink's main() on its own small stack.
+// Blocking receives, sleeps and the final exit() switch back to the worker
+// thread, which picks up the next runnable node. Sends are buffered, so
+// MPI_Send never blocks. Collectives are binomial trees over point-to-point
+// messages, as a real MPI would do them.
+//
+// Sleeps are scaled by the -t time scale; the default of 0 turns them into
+// plain yields, so a run measures how fast the runtime itself can move
+// frames between nodes.
+//
+// With -V the cluster runs on a virtual clock instead. Sleeping nodes wait
+// in a heap and, once no node can run, the clock jumps straight to the
+// earliest wake-up, so a pattern that takes minutes on the wall finishes
+// in milliseconds. MPI_Wtime() reports virtual time. -T records every pin
+// transition of every node with its virtual timestamp; with one worker the
+// trace is deterministic and `make check` compares it against the golden
+// traces in golden/.
+//
+// Date: 2026-10-19
+//============================================================================
+
+#define VCLUSTER_RUNTIME
+
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdarg.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <ucontext.h>
+#include <time.h>
+#include <sys/mman.h>
+#include "mpi.h"
+#include "wiringPi.h"
+
+#define NPINS           8
+#define TAG_BCAST       (-2)
+#define TAG_BARRIER     (-3)
+#define TAG_REDUCE      (-4)
+#define TAG_SPLIT       (-5)
+#define TAG_NEIGHBOR    (-6)
+#define MAX_WINDOWS     8
+#define MAX_COMMS       16
+
+enum yield_reason {
+    YIELD_READY,
+    YIELD_WAIT,
+    YIELD_SLEEP,
+    YIELD_DONE
+};
+
+struct message {
+    struct message *next;
+    int src;
+    int tag;
+    bool coll;      // collective traffic never matches user receives
+    int len;
+    char data[];
+};
+
+struct event {
+    uint64_t t;
+    int rank;
+    int seq;
+    int pin;
+    int value;
+};
+
+struct vnode {
+    int rank;
+    ucontext_t ctx;
+    ucontext_t *sched;
+    char *stack;
+    size_t stack_size;
+    enum yield_reason reason;
+    uint64_t wake_at;   // us, on the real or virtual clock
+    struct vnode *next;
+
+    // Mailbox. waiting/parked/woken hand a blocked node back to the run
+    // queue exactly once, whichever of sender and worker gets there last.
+    pthread_mutex_t lock;
+    struct message *head;
+    struct message *tail;
+    bool waiting;
+    bool parked;
+    bool woken;
+
+    int pins[NPINS];
+    struct event *events;
+    int nevents;
+    int cap_events;
+    unsigned long frames;
+    unsigned long sent;
+    unsigned long writes;
+    unsigned long switches;
+
+    // RMA windows, indexed by MPI_Win. Allocation is collective, so every
+    // node hands out the same index for the same window.
+    char *windows[MAX_WINDOWS];
+    int disp_units[MAX_WINDOWS];
+    int nwindows;
+};
+
+// A communicator split from MPI_COMM_WORLD, indexed by MPI_Comm. Rank 0
+// builds them all, so every member sees the same handle. ndims is set once
+// the comm is a Cartesian grid. The slot is reused once every member has
+// freed every handle to it.
+struct vcomm {
+    int size;
+    int *ranks;         // world rank of each comm rank
+    int *rank_of;       // comm rank of each world rank, -1 if not a member
+    int ndims;
+    int dims[2];
+    int refs;           // open handles, one per member per alias
+    int next_free;      // next slot on the free list, 0 at its end
+};
+
+struct cluster {
+    int nnodes;
+    int nworkers;
+    struct vnode *nodes;
+    double timescale;
+    bool virtual_time;
+    bool trace;
+    const char *trace_path;
+    bool quiet;
+    int argc;
+    char **argv;
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    struct vnode *rq_head;
+    struct vnode *rq_tail;
+    struct vnode **sleepers;    // min-heap on wake_at
+    int nsleepers;
+    int live;
+    int running;
+    bool deadlock;
+    uint64_t vnow;      // virtual clock (us), only advanced while no node runs
+
+    struct vcomm comms[MAX_COMMS];  // [0] is unused, MPI_COMM_WORLD
+    int ncomms;         // slots ever used
+    int free_comms;     // head of the free list, 0 if empty
+};
+
+struct run_stats {
+    double wall;
+    unsigned long frames;
+    unsigned long messages;
+    unsigned long writes;
+    unsigned long switches;
+    double rss_per_node;
+    double vtime;
+};
+
+extern int pblink_main(int argc, char **argv);
+
+static struct cluster C;
+static __thread struct vnode *current;
+
+static double now(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint64_t now_us(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static uint64_t clock_us(void) {
+    return C.virtual_time ? C.vnow : now_us();
+}
+
+static long rss_bytes(void) {
+    FILE *fp = fopen("/proc/self/statm", "r");
+    long size = 0, rss = 0;
+
+    if (fp != NULL) {
+        if (fscanf(fp, "%ld %ld", &size, &rss) != 2) {
+            rss = 0;
+        }
+        fclose(fp);
+    }
+
+    return rss * sysconf(_SC_PAGESIZE);
+}
+
+//----------------------------------------------------------------------------
+// Scheduler (C.lock held)
+//----------------------------------------------------------------------------
+
+static void rq_push(struct vnode *n) {
+    n->next = NULL;
+    if (C.rq_tail) {
+        C.rq_tail->next = n;
+    } else {
+        C.rq_head = n;
+    }
+    C.rq_tail = n;
+    pthread_cond_signal(&C.cond);
+}
+
+static struct vnode *rq_pop(void) {
+    struct vnode *n = C.rq_head;
+
+    if (n) {
+        C.rq_head = n->next;
+        if (C.rq_head == NULL) {
+            C.rq_tail = NULL;
+        }
+    }
+
+    return n;
+}
+
+static void sleep_push(struct vnode *n) {
+    int i = C.nsleepers++;
+
+    while (i > 0 && C.sleepers[(i - 1) / 2]->wake_at > n->wake_at) {
+        C.sleepers[i] = C.sleepers[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    C.sleepers[i] = n;
+}
+
+static struct vnode *sleep_pop(void) {
+    struct vnode *top = C.sleepers[0];
+    struct vnode *last = C.sleepers[--C.nsleepers];
+    int i = 0;
+
+    while (2 * i + 1 < C.nsleepers) {
+        int c = 2 * i + 1;
+
+        if (c + 1 < C.nsleepers && C.sleepers[c + 1]->wake_at < C.sleepers[c]->wake_at) {
+            c++;
+        }
+        if (last->wake_at <= C.sleepers[c]->wake_at) {
+            break;
+        }
+        C.sleepers[i] = C.sleepers[c];
+        i = c;
+    }
+    C.sleepers[i] = last;
+
+    return top;
+}
+
+static void wake_sleepers(uint64_t t) {
+    while (C.nsleepers > 0 && C.sleepers[0]->wake_at <= t) {
+        rq_push(sleep_pop());
+    }
+}
+
+//----------------------------------------------------------------------------
+// Workers
+//----------------------------------------------------------------------------
+
+static void *worker(void *arg) {
+    ucontext_t sched;
+
+    pthread_mutex_lock(&C.lock);
+
+    while (1) {
+        struct vnode *n;
+        bool requeue = false;
+
+        while ((n = rq_pop()) == NULL) {
+            wake_sleepers(clock_us());
+            if (C.rq_head) {
+                continue;
+            }
+
+            if (C.live == 0 || C.deadlock) {
+                pthread_cond_broadcast(&C.cond);
+                pthread_mutex_unlock(&C.lock);
+                return NULL;
+            }
+
+            if (C.running == 0 && C.nsleepers == 0) {
+                C.deadlock = true;
+                continue;
+            }
+
+            if (C.virtual_time && C.nsleepers > 0 && C.running == 0) {
+                // Nothing can happen before the next wake-up: skip to it
+                C.vnow = C.sleepers[0]->wake_at;
+                continue;
+            }
+
+            if (!C.virtual_time && C.nsleepers > 0) {
+                uint64_t wait = C.sleepers[0]->wake_at - now_us();
+                struct timespec ts;
+
+                // C.cond waits on CLOCK_REALTIME
+                clock_gettime(CLOCK_REALTIME, &ts);
+                wait += ts.tv_nsec / 1000;
+                ts.tv_sec += wait / 1000000;
+                ts.tv_nsec = (wait % 1000000) * 1000;
+                pthread_cond_timedwait(&C.cond, &C.lock, &ts);
+            } else {
+                pthread_cond_wait(&C.cond, &C.lock);
+            }
+        }
+
+        C.running++;
+        pthread_mutex_unlock(&C.lock);
+
+        n->sched = &sched;
+        current = n;
+        swapcontext(&sched, &n->ctx);
+        current = NULL;
+
+        if (n->reason == YIELD_WAIT) {
+            pthread_mutex_lock(&n->lock);
+            if (n->woken) {
+                n->woken = false;
+                requeue = true;
+            } else {
+                n->parked = true;
+            }
+            pthread_mutex_unlock(&n->lock);
+        }
+
+        pthread_mutex_lock(&C.lock);
+        C.running--;
+
+        if (n->reason == YIELD_READY || requeue) {
+            rq_push(n);
+        } else if (n->reason == YIELD_SLEEP) {
+            sleep_push(n);
+            pthread_cond_signal(&C.cond);
+        } else if (n->reason == YIELD_DONE) {
+            C.live--;
+        }
+
+        if (C.live == 0 || C.running == 0) {
+            pthread_cond_broadcast(&C.cond);
+        }
+    }
+}
+
+// The calling virtual node. pblink's multistrobe (mode 13) makes MPI calls
+// from threads of its own, which a coroutine runtime cannot host.
+static struct vnode *self(void) {
+    struct vnode *me = current;
+
+    if (me == NULL) {
+        fprintf(stderr, "vcluster: MPI or GPIO call from a thread that is not a virtual node\n");
+        exit(1);
+    }
+
+    return me;
+}
+
+static void yield(struct vnode *me, enum yield_reason reason) {
+    me->reason = reason;
+    me->switches++;
+    swapcontext(&me->ctx, me->sched);
+}
+
+static void node_main(void) {
+    pblink_main(C.argc, C.argv);
+    vc_exit(0);
+}
+
+//----------------------------------------------------------------------------
+// Messaging
+//----------------------------------------------------------------------------
+
+static void deliver(struct vnode *from, int dest, int tag, bool coll, const void *buf, int len) {
+    struct vnode *to;
+    struct message *m;
+    bool wake = false;
+
+    if (dest < 0 || dest >= C.nnodes) {
+        fprintf(stderr, "vcluster: rank %d sent to rank %d, but only %d nodes exist\n", from->rank, dest, C.nnodes);
+        exit(1);
+    }
+
+    to = &C.nodes[dest];
+    m = malloc(sizeof(struct message) + len);
+    m->next = NULL;
+    m->src = from->rank;
+    m->tag = tag;
+    m->coll = coll;
+    m->len = len;
+    memcpy(m->data, buf, len);
+    from->sent++;
+
+    pthread_mutex_lock(&to->lock);
+    if (to->tail) {
+        to->tail->next = m;
+    } else {
+        to->head = m;
+    }
+    to->tail = m;
+
+    if (to->waiting) {
+        to->waiting = false;
+        if (to->parked) {
+            to->parked = false;
+            wake = true;
+        } else {
+            to->woken = true;
+        }
+    }
+    pthread_mutex_unlock(&to->lock);
+
+    if (wake) {
+        pthread_mutex_lock(&C.lock);
+        rq_push(to);
+        pthread_mutex_unlock(&C.lock);
+    }
+}
+
+static struct message *receive(struct vnode *me, int src, int tag, bool coll) {
+    while (1) {
+        struct message *m, *prev = NULL;
+
+        pthread_mutex_lock(&me->lock);
+        for (m = me->head; m != NULL; prev = m, m = m->next) {
+            if (m->coll == coll && (src == MPI_ANY_SOURCE || m->src == src) && (tag == MPI_ANY_TAG || m->tag == tag)) {
+                if (prev) {
+                    prev->next = m->next;
+                } else {
+                    me->head = m->next;
+                }
+                if (me->tail == m) {
+                    me->tail = prev;
+                }
+                pthread_mutex_unlock(&me->lock);
+                return m;
+            }
+        }
+
+        me->waiting = true;
+        pthread_mutex_unlock(&me->lock);
+        yield(me, YIELD_WAIT);
+    }
+}
+
+//----------------------------------------------------------------------------
+// MPI subset
+//----------------------------------------------------------------------------
+
+int MPI_Init(int *argc, char ***argv) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Finalize(void) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Abort(MPI_Comm comm, int code) {
+    fprintf(stderr, "vcluster: rank %d called MPI_Abort(%d)\n", self()->rank, code);
+    exit(code);
+}
+
+int MPI_Comm_size(MPI_Comm comm, int *size) {
+    *size = comm == MPI_COMM_WORLD ? C.nnodes : C.comms[comm].size;
+    return MPI_SUCCESS;
+}
+
+int MPI_Comm_rank(MPI_Comm comm, int *rank) {
+    *rank = comm == MPI_COMM_WORLD ? self()->rank : C.comms[comm].rank_of[self()->rank];
+    return MPI_SUCCESS;
+}
+
+static int type_size(MPI_Datatype type) {
+    switch (type) {
+        case MPI_BYTE: return 1;
+        case MPI_CHAR: return sizeof(char);
+        case MPI_INT: return sizeof(int);
+        case MPI_LONG: return sizeof(long);
+        case MPI_FLOAT: return sizeof(float);
+        case MPI_DOUBLE: return sizeof(double);
+    }
+    fprintf(stderr, "vcluster: unsupported datatype %d\n", type);
+    exit(1);
+}
+
+int MPI_Send(const void *buf, int count, MPI_Datatype type, int dest, int tag, MPI_Comm comm) {
+    struct vnode *me = self();
+
+    if (me->rank == 0) {
+        me->frames++;
+    }
+
+    deliver(me, dest, tag, false, buf, count * type_size(type));
+    return MPI_SUCCESS;
+}
+
+int MPI_Recv(void *buf, int count, MPI_Datatype type, int source, int tag, MPI_Comm comm, MPI_Status *status) {
+    struct message *m = receive(self(), source, tag, false);
+    int size = count * type_size(type);
+    int len = m->len < size ? m->len : size;
+
+    memcpy(buf, m->data, len);
+    if (status != MPI_STATUS_IGNORE) {
+        status->MPI_SOURCE = m->src;
+        status->MPI_TAG = m->tag;
+        status->count = len;
+    }
+
+    free(m);
+    return MPI_SUCCESS;
+}
+
+int MPI_Get_count(const MPI_Status *status, MPI_Datatype type, int *count) {
+    *count = status->count / type_size(type);
+    return MPI_SUCCESS;
+}
+
+// Binomial tree fan-out from root, in collective context
+static void tree_bcast(struct vnode *me, void *buf, int len, int root, int tag) {
+    int n = C.nnodes;
+    int r = (me->rank - root + n) % n;
+    int mask = 1;
+
+    while (mask < n) {
+        if (r & mask) {
+            struct message *m = receive(me, (r - mask + root) % n, tag, true);
+
+            memcpy(buf, m->data, m->len < len ? m->len : len);
+            free(m);
+            break;
+        }
+        mask <<= 1;
+    }
+
+    for (mask >>= 1; mask > 0; mask >>= 1) {
+        if (r + mask < n) {
+            deliver(me, (r + mask + root) % n, tag, true, buf, len);
+        }
+    }
+}
+
+int MPI_Bcast(void *buf, int count, MPI_Datatype type, int root, MPI_Comm comm) {
+    struct vnode *me = self();
+
+    if (me->rank == 0) {
+        me->frames++;
+    }
+
+    tree_bcast(me, buf, count * type_size(type), root, TAG_BCAST);
+    return MPI_SUCCESS;
+}
+
+int MPI_Barrier(MPI_Comm comm) {
+    struct vnode *me = self();
+    int r = me->rank;
+    int mask = 1;
+
+    // Fan in to rank 0 along the same tree, then fan back out
+    while (mask < C.nnodes) {
+        if (r & mask) {
+            deliver(me, r - mask, TAG_BARRIER, true, NULL, 0);
+            break;
+        }
+        if (r + mask < C.nnodes) {
+            free(receive(me, r + mask, TAG_BARRIER, true));
+        }
+        mask <<= 1;
+    }
+
+    tree_bcast(me, NULL, 0, 0, TAG_BARRIER);
+    return MPI_SUCCESS;
+}
+
+// Element-wise combine of one contribution into the accumulator
+#define REDUCE_AS(T) do { \
+        T *a = acc; const T *b = in; \
+        for (int i = 0; i < count; i++) { \
+            a[i] = op == MPI_SUM ? a[i] + b[i] : \
+                   op == MPI_MAX ? (a[i] > b[i] ? a[i] : b[i]) : \
+                                   (a[i] < b[i] ? a[i] : b[i]); \
+        } \
+    } while (0)
+
+static void combine(void *acc, const void *in, int count, MPI_Datatype type, MPI_Op op) {
+    switch (type) {
+        case MPI_INT: REDUCE_AS(int); break;
+        case MPI_LONG: REDUCE_AS(long); break;
+        case MPI_FLOAT: REDUCE_AS(float); break;
+        case MPI_DOUBLE: REDUCE_AS(double); break;
+        default:
+            fprintf(stderr, "vcluster: unsupported reduce datatype %d\n", type);
+            exit(1);
+    }
+}
+
+int MPI_Reduce(const void *sendbuf, void *recvbuf, int count, MPI_Datatype type, MPI_Op op, int root, MPI_Comm comm) {
+    struct vnode *me = self();
+    int len = count * type_size(type);
+
+    // Linear gather: the walls are small and this runs once per job
+    if (me->rank != root) {
+        deliver(me, root, TAG_REDUCE, true, sendbuf, len);
+        return MPI_SUCCESS;
+    }
+
+    memcpy(recvbuf, sendbuf, len);
+    for (int i = 0; i < C.nnodes; i++) {
+        if (i != root) {
+            struct message *m = receive(me, i, TAG_REDUCE, true);
+
+            combine(recvbuf, m->data, count, type, op);
+            free(m);
+        }
+    }
+
+    return MPI_SUCCESS;
+}
+
+static int cmp_split(const void *a, const void *b) {
+    const int *x = a, *y = b;
+
+    // color, key, then world rank
+    for (int i = 0; i < 3; i++) {
+        if (x[i] != y[i]) {
+            return x[i] < y[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+// A free slot for a new comm, reusing freed ones first
+static int comm_alloc(void) {
+    int h;
+
+    pthread_mutex_lock(&C.lock);
+    if (C.free_comms != 0) {
+        h = C.free_comms;
+        C.free_comms = C.comms[h].next_free;
+    } else if (C.ncomms + 1 < MAX_COMMS) {
+        h = ++C.ncomms;
+    } else {
+        fprintf(stderr, "vcluster: out of communicators\n");
+        exit(1);
+    }
+    pthread_mutex_unlock(&C.lock);
+
+    memset(&C.comms[h], 0, sizeof(C.comms[h]));
+    return h;
+}
+
+int MPI_Comm_split(MPI_Comm comm, int color, int key, MPI_Comm *newcomm) {
+    struct vnode *me = self();
+    int mine[3] = {color, key, me->rank};
+    int *handles = malloc(C.nnodes * sizeof(int));
+
+    if (comm != MPI_COMM_WORLD) {
+        fprintf(stderr, "vcluster: MPI_Comm_split only splits MPI_COMM_WORLD\n");
+        exit(1);
+    }
+
+    // Rank 0 gathers every (color, key), builds one comm per color in
+    // (key, rank) order and hands each node its handle
+    if (me->rank != 0) {
+        deliver(me, 0, TAG_SPLIT, true, mine, sizeof(mine));
+    } else {
+        int (*all)[3] = malloc(C.nnodes * sizeof(*all));
+
+        memcpy(all[0], mine, sizeof(mine));
+        for (int i = 1; i < C.nnodes; i++) {
+            struct message *m = receive(me, i, TAG_SPLIT, true);
+
+            memcpy(all[i], m->data, sizeof(mine));
+            free(m);
+        }
+        qsort(all, C.nnodes, sizeof(*all), cmp_split);
+
+        int h = MPI_COMM_NULL;
+
+        for (int i = 0; i < C.nnodes; i++) {
+            struct vcomm *c;
+
+            if (all[i][0] == MPI_UNDEFINED) {
+                handles[all[i][2]] = MPI_COMM_NULL;
+                continue;
+            }
+            if (h == MPI_COMM_NULL || all[i][0] != all[i - 1][0]) {
+                h = comm_alloc();
+                c = &C.comms[h];
+                c->ranks = malloc(C.nnodes * sizeof(int));
+                c->rank_of = malloc(C.nnodes * sizeof(int));
+                memset(c->rank_of, -1, C.nnodes * sizeof(int));
+            }
+            c = &C.comms[h];
+            c->rank_of[all[i][2]] = c->size;
+            c->ranks[c->size++] = all[i][2];
+            c->refs++;
+            handles[all[i][2]] = h;
+        }
+        free(all);
+    }
+
+    tree_bcast(me, handles, C.nnodes * sizeof(int), 0, TAG_SPLIT);
+    *newcomm = handles[me->rank];
+    free(handles);
+    return MPI_SUCCESS;
+}
+
+// The last handle freed releases the slot
+int MPI_Comm_free(MPI_Comm *comm) {
+    struct vcomm *c;
+
+    if (*comm == MPI_COMM_WORLD || *comm == MPI_COMM_NULL) {
+        fprintf(stderr, "vcluster: MPI_Comm_free needs a split comm\n");
+        exit(1);
+    }
+
+    c = &C.comms[*comm];
+    pthread_mutex_lock(&C.lock);
+    if (--c->refs == 0) {
+        free(c->ranks);
+        free(c->rank_of);
+        c->ranks = NULL;
+        c->rank_of = NULL;
+        c->size = 0;
+        c->next_free = C.free_comms;
+        C.free_comms = *comm;
+    }
+    pthread_mutex_unlock(&C.lock);
+
+    *comm = MPI_COMM_NULL;
+    return MPI_SUCCESS;
+}
+
+// Two dimensions only, as square as nnodes allows, larger dimension first
+int MPI_Dims_create(int nnodes, int ndims, int *dims) {
+    int f = 1;
+
+    if (ndims != 2 || dims[0] != 0 || dims[1] != 0) {
+        fprintf(stderr, "vcluster: MPI_Dims_create only fills an empty 2-d grid\n");
+        exit(1);
+    }
+
+    for (int i = 1; i * i <= nnodes; i++) {
+        if (nnodes % i == 0) {
+            f = i;
+        }
+    }
+    dims[0] = nnodes / f;
+    dims[1] = f;
+    return MPI_SUCCESS;
+}
+
+// Non-periodic, never reordered: the grid is the comm itself, laid out in
+// row-major rank order. It is another handle to the comm's slot, freed
+// separately.
+int MPI_Cart_create(MPI_Comm comm, int ndims, const int *dims, const int *periods, int reorder, MPI_Comm *cart) {
+    struct vcomm *c = &C.comms[comm];
+
+    if (comm == MPI_COMM_WORLD || ndims != 2 || periods[0] || periods[1] || dims[0] * dims[1] != c->size) {
+        fprintf(stderr, "vcluster: MPI_Cart_create needs a split comm and a non-periodic 2-d grid of its size\n");
+        exit(1);
+    }
+
+    // Every member stores the same shape
+    pthread_mutex_lock(&C.lock);
+    c->ndims = ndims;
+    c->dims[0] = dims[0];
+    c->dims[1] = dims[1];
+    c->refs++;
+    pthread_mutex_unlock(&C.lock);
+
+    *cart = comm;
+    return MPI_SUCCESS;
+}
+
+int MPI_Cart_coords(MPI_Comm comm, int rank, int maxdims, int *coords) {
+    struct vcomm *c = &C.comms[comm];
+
+    coords[0] = rank / c->dims[1];
+    coords[1] = rank % c->dims[1];
+    return MPI_SUCCESS;
+}
+
+// Neighbors in MPI order: -1 then +1 along each dimension. Slots for
+// neighbors off the edge of the grid are left untouched.
+int MPI_Neighbor_allgather(const void *sendbuf, int scount, MPI_Datatype stype, void *recvbuf, int rcount,
+        MPI_Datatype rtype, MPI_Comm comm) {
+    struct vnode *me = self();
+    struct vcomm *c = &C.comms[comm];
+    int r = c->rank_of[me->rank];
+    int coords[2], nbr[4];
+    int len = rcount * type_size(rtype);
+
+    MPI_Cart_coords(comm, r, 2, coords);
+    for (int d = 0; d < 2; d++) {
+        int stride = d == 0 ? c->dims[1] : 1;
+
+        nbr[2 * d] = coords[d] > 0 ? c->ranks[r - stride] : -1;
+        nbr[2 * d + 1] = coords[d] < c->dims[d] - 1 ? c->ranks[r + stride] : -1;
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (nbr[i] >= 0) {
+            deliver(me, nbr[i], TAG_NEIGHBOR, true, sendbuf, scount * type_size(stype));
+        }
+    }
+
+    for (int i = 0; i < 4; i++) {
+        if (nbr[i] >= 0) {
+            struct message *m = receive(me, nbr[i], TAG_NEIGHBOR, true);
+
+            memcpy((char *) recvbuf + i * len, m->data, m->len < len ? m->len : len);
+            free(m);
+        }
+    }
+
+    // Every node shows a frame per exchange
+    me->frames++;
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_allocate(long size, int disp_unit, MPI_Info info, MPI_Comm comm, void *baseptr, MPI_Win *win) {
+    struct vnode *me = self();
+
+    if (me->nwindows == MAX_WINDOWS) {
+        fprintf(stderr, "vcluster: rank %d is out of RMA windows\n", me->rank);
+        exit(1);
+    }
+
+    me->windows[me->nwindows] = calloc(1, size > 0 ? size : 1);
+    me->disp_units[me->nwindows] = disp_unit;
+    *(void **) baseptr = me->windows[me->nwindows];
+    *win = me->nwindows++;
+
+    // No node may put into a window its owner has not yet allocated
+    return MPI_Barrier(comm);
+}
+
+int MPI_Win_free(MPI_Win *win) {
+    struct vnode *me = self();
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    free(me->windows[*win]);
+    me->windows[*win] = NULL;
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_lock_all(int assert, MPI_Win win) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_unlock_all(MPI_Win win) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_flush(int rank, MPI_Win win) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_flush_all(MPI_Win win) {
+    return MPI_SUCCESS;
+}
+
+int MPI_Win_sync(MPI_Win win) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return MPI_SUCCESS;
+}
+
+int MPI_Put(const void *origin, int origin_count, MPI_Datatype origin_type, int target, long target_disp,
+        int target_count, MPI_Datatype target_type, MPI_Win win) {
+    struct vnode *me = self();
+    struct vnode *to = &C.nodes[target];
+
+    // Puts complete on return; the target's lock orders them against
+    // anything else touching that node
+    pthread_mutex_lock(&to->lock);
+    memcpy(to->windows[win] + target_disp * to->disp_units[win], origin,
+            origin_count * type_size(origin_type));
+    pthread_mutex_unlock(&to->lock);
+
+    if (me->rank == 0) {
+        me->frames++;
+    }
+    me->sent++;
+    return MPI_SUCCESS;
+}
+
+double MPI_Wtime(void) {
+    return C.virtual_time ? C.vnow * 1e-6 : now();
+}
+
+void vc_usleep(unsigned int us) {
+    struct vnode *me = self();
+
+    if (C.virtual_time) {
+        me->wake_at = C.vnow + us;
+        yield(me, YIELD_SLEEP);
+    } else if (C.timescale <= 0) {
+        yield(me, YIELD_READY);
+    } else {
+        me->wake_at = now_us() + (uint64_t) (us * C.timescale);
+        yield(me, YIELD_SLEEP);
+    }
+}
+
+void vc_exit(int code) {
+    yield(self(), YIELD_DONE);
+    abort();
+}
+
+int vc_printf(const char *fmt, ...) {
+    va_list ap;
+    int n;
+
+    if (C.quiet) {
+        return 0;
+    }
+
+    va_start(ap, fmt);
+    n = vprintf(fmt, ap);
+    va_end(ap);
+    return n;
+}
+
+//----------------------------------------------------------------------------
+// GPIO
+//----------------------------------------------------------------------------
+
+int wiringPiSetup(void) {
+    return 0;
+}
+
+void pinMode(int pin, int mode) {
+}
+
+// Pins start out undefined (-1), so the first write always shows up as a
+// transition in the trace.
+void digitalWrite(int pin, int value) {
+    struct vnode *me = self();
+
+    pin %= NPINS;
+    me->writes++;
+
+    if (C.trace && me->pins[pin] != value) {
+        if (me->nevents == me->cap_events) {
+            me->cap_events = me->cap_events ? me->cap_events * 2 : 256;
+            me->events = realloc(me->events, me->cap_events * sizeof(struct event));
+        }
+
+        me->events[me->nevents] = (struct event) {clock_us(), me->rank, me->nevents, pin, value};
+        me->nevents++;
+    }
+
+    me->pins[pin] = value;
+}
+
+int digitalRead(int pin) {
+    int value = self()->pins[pin % NPINS];
+
+    return value < 0 ? 0 : value;
+}
+
+int piHiPri(int pri) {
+    return 0;
+}
+
+//----------------------------------------------------------------------------
+// Cluster
+//----------------------------------------------------------------------------
+
+static int cmp_event(const void *a, const void *b) {
+    const struct event *x = a;
+    const struct event *y = b;
+
+    if (x->t != y->t) {
+        return x->t < y->t ? -1 : 1;
+    }
+    if (x->rank != y->rank) {
+        return x->rank - y->rank;
+    }
+    return x->seq - y->seq;
+}
+
+// Merges the per-node transitions into one time-ordered trace:
+// <time us> <rank> <pin> <value>
+static int write_trace(const char *path) {
+    FILE *fp = fopen(path, "w");
+    struct event *all;
+    int total = 0;
+
+    if (fp == NULL) {
+        fprintf(stderr, "Error opening %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    for (int i = 0; i < C.nnodes; i++) {
+        total += C.nodes[i].nevents;
+    }
+
+    all = malloc((total + 1) * sizeof(struct event));
+    total = 0;
+    for (int i = 0; i < C.nnodes; i++) {
+        memcpy(all + total, C.nodes[i].events, C.nodes[i].nevents * sizeof(struct event));
+        total += C.nodes[i].nevents;
+    }
+
+    qsort(all, total, sizeof(struct event), cmp_event);
+
+    fprintf(fp, "# vcluster trace: %d nodes, time_us rank pin value\n", C.nnodes);
+    for (int i = 0; i < total; i++) {
+        fprintf(fp, "%llu %d %d %d\n", (unsigned long long) all[i].t, all[i].rank, all[i].pin, all[i].value);
+    }
+
+    free(all);
+    fclose(fp);
+    return 0;
+}
+
+static int cluster_run(int nnodes, int nworkers, size_t stack_size, int argc, char **argv, struct run_stats *rs) {
+    long page = sysconf(_SC_PAGESIZE);
+    pthread_t *threads;
+    long rss_before;
+    double start;
+    int ret = 0;
+
+    memset(rs, 0, sizeof(*rs));
+    memset(&C.lock, 0, sizeof(C) - offsetof(struct cluster, lock));
+    pthread_mutex_init(&C.lock, NULL);
+    pthread_cond_init(&C.cond, NULL);
+    C.nnodes = nnodes;
+    C.nworkers = nworkers;
+    C.argc = argc;
+    C.argv = argv;
+    C.live = nnodes;
+
+    rss_before = rss_bytes();
+    C.nodes = calloc(nnodes, sizeof(struct vnode));
+    C.sleepers = calloc(nnodes, sizeof(struct vnode*));
+
+    for (int i = 0; i < nnodes; i++) {
+        struct vnode *n = &C.nodes[i];
+
+        // Stacks are reserved, not committed: only touched pages cost RAM.
+        // The lowest page is a guard against overflow.
+        n->rank = i;
+        n->stack_size = stack_size;
+        n->stack = mmap(NULL, stack_size + page, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (n->stack == MAP_FAILED) {
+            perror("mmap");
+            return -1;
+        }
+        mprotect(n->stack, page, PROT_NONE);
+        pthread_mutex_init(&n->lock, NULL);
+        memset(n->pins, -1, sizeof(n->pins));
+
+        getcontext(&n->ctx);
+        n->ctx.uc_stack.ss_sp = n->stack + page;
+        n->ctx.uc_stack.ss_size = stack_size;
+        n->ctx.uc_link = NULL;
+        makecontext(&n->ctx, node_main, 0);
+        rq_push(n);
+    }
+
+    threads = malloc(nworkers * sizeof(pthread_t));
+    start = now();
+
+    for (int i = 0; i < nworkers; i++) {
+        pthread_create(&threads[i], NULL, worker, NULL);
+    }
+
+    for (int i = 0; i < nworkers; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    rs->wall = now() - start;
+    rs->rss_per_node = (double) (rss_bytes() - rss_before) / nnodes;
+    // Rank 0 counts the frames it sends; in the decentralized modes each
+    // node counts its own
+    for (int i = 0; i < nnodes; i++) {
+        if (C.nodes[i].frames > rs->frames) {
+            rs->frames = C.nodes[i].frames;
+        }
+    }
+    rs->vtime = C.vnow * 1e-6;
+
+    if (C.trace && write_trace(C.trace_path) == -1) {
+        ret = -1;
+    }
+
+    for (int i = 0; i < nnodes; i++) {
+        struct vnode *n = &C.nodes[i];
+
+        rs->messages += n->sent;
+        rs->writes += n->writes;
+        rs->switches += n->switches;
+
+        while (n->head) {
+            struct message *m = n->head;
+
+            n->head = m->next;
+            free(m);
+        }
+
+        for (int w = 0; w < n->nwindows; w++) {
+            free(n->windows[w]);
+        }
+        free(n->events);
+        munmap(n->stack, stack_size + page);
+        pthread_mutex_destroy(&n->lock);
+    }
+
+    for (int i = 1; i <= C.ncomms; i++) {
+        free(C.comms[i].ranks);
+        free(C.comms[i].rank_of);
+    }
+
+    free(threads);
+    free(C.nodes);
+    free(C.sleepers);
+
+    if (C.deadlock) {
+        fprintf(stderr, "vcluster: deadlock, %d of %d nodes blocked forever\n", C.live, nnodes);
+        return -1;
+    }
+
+    return ret;
+}
+
+static void print_header(void) {
+    printf("%8s %8s %10s %10s %12s %12s %12s %10s\n",
+            "nodes", "workers", "wall (s)", "frames", "frames/s", "msgs/s", "switches", "KiB/node");
+}
+
+static void print_stats(int nnodes, int nworkers, struct run_stats *rs) {
+    printf("%8d %8d %10.3f %10lu %12.1f %12.0f %12lu %10.1f\n",
+            nnodes, nworkers, rs->wall, rs->frames, rs->frames / rs->wall,
+            rs->messages / rs->wall, rs->switches, rs->rss_per_node / 1024);
+    fflush(stdout);
+}
+
+void usage(char *progname) {
+    fprintf(stderr, "Usage: %s [-n nodes] [-w workers] [-s stack KiB] [-t timescale | -V] [-T trace] [-q] -- <blink rate (ms)> [mode] [iterations] [mask]\n", progname);
+    fprintf(stderr, "       %s -B [-N max nodes] [-m mode] [-i iterations] [-w workers] [-s stack KiB]\n", progname);
+    fprintf(stderr, "  -n  virtual nodes (default 33: rank 0 plus the 32 node wall)\n");
+    fprintf(stderr, "  -w  worker threads (default: online CPUs)\n");
+    fprintf(stderr, "  -t  sleep time scale, 0 turns sleeps into yields (default 0)\n");
+    fprintf(stderr, "  -V  run on a virtual clock: sleeps take no wall time\n");
+    fprintf(stderr, "  -T  write every pin transition to a trace file\n");
+    fprintf(stderr, "  -q  suppress pblink output\n");
+    fprintf(stderr, "  -B  run a pblink mode on walls of 32, 64, ... up to -N nodes (default 1024) plus rank 0\n");
+}
+
+int main(int argc, char **argv) {
+    int nnodes = 33;
+    int nworkers = sysconf(_SC_NPROCESSORS_ONLN);
+    size_t stack_kib = 64;
+    bool bench = false;
+    int max_nodes = 1024;
+    int mode = 12;
+    int iterations = 200;
+    struct run_stats rs;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:w:s:t:VT:qBN:m:i:")) != -1) {
+        switch (opt) {
+            case 'n': nnodes = atoi(optarg); break;
+            case 'w': nworkers = atoi(optarg); break;
+            case 's': stack_kib = atoi(optarg); break;
+            case 't': C.timescale = atof(optarg); break;
+            case 'V': C.virtual_time = true; break;
+            case 'T': C.trace = true; C.trace_path = optarg; break;
+            case 'q': C.quiet = true; break;
+            case 'B': bench = true; break;
+            case 'N': max_nodes = atoi(optarg); break;
+            case 'm': mode = atoi(optarg); break;
+            case 'i': iterations = atoi(optarg); break;
+            default:
+                usage(argv[0]);
+                exit(1);
+        }
+    }
+
+    if (nnodes < 1 || nworkers < 1 || stack_kib < 16 || (!bench && optind >= argc)) {
+        usage(argv[0]);
+        exit(1);
+    }
+
+    if (bench) {
+        char rate[] = "1";
+        char mode_arg[16];
+        char iter_arg[16];
+        char *args[] = {"pblink", rate, mode_arg, iter_arg, NULL};
+
+        snprintf(mode_arg, sizeof(mode_arg), "%d", mode);
+        snprintf(iter_arg, sizeof(iter_arg), "%d", iterations);
+        C.quiet = true;
+        C.timescale = 0;
+
+        printf("pblink mode %d, %d iterations, %zu KiB stacks\n", mode, iterations, stack_kib);
+        print_header();
+
+        // A wall of 32, 64, ... nodes plus rank 0 driving it
+        for (int n = 32; n <= max_nodes; n *= 2) {
+            if (cluster_run(n + 1, nworkers, stack_kib * 1024, 4, args, &rs) == -1) {
+                exit(1);
+            }
+            print_stats(n + 1, nworkers, &rs);
+        }
+
+        exit(0);
+    }
+
+    // Hand pblink its own argv, with argv[0] in place of the "--"
+    argv[optind - 1] = "pblink";
+    if (cluster_run(nnodes, nworkers, stack_kib * 1024, argc - optind + 1, argv + optind - 1, &rs) == -1) {
+        exit(1);
+    }
+
+    print_header();
+    print_stats(nnodes, nworkers, &rs);
+    if (C.virtual_time) {
+        printf("virtual time: %.6f s\n", rs.vtime);
+    }
+    exit(0);
+}
@@ -0,0 +1,23 @@
+//============================================================================
+// Name        : wiringPi.h
+// Description : Stand-in for the wiringPi GPIO calls used by pblink. Pin
+//               writes update the LED state of the calling virtual node.
+//
+// Date: 2026-10-19
+//============================================================================
+
+#ifndef VCLUSTER_WIRINGPI_H
+#define VCLUSTER_WIRINGPI_H
+
+#define INPUT   0
+#define OUTPUT  1
+#define LOW     0
+#define HIGH    1
+
+int wiringPiSetup(void);
+void pinMode(int pin, int mode);
+void digitalWrite(int pin, int value);
+int digitalRead(int pin);
+int piHiPri(int pri);
+
+#endif